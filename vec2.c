@@ -7,149 +7,1645 @@
 /* 2015.08.02: katahiromz creates v2.                                       */
 /****************************************************************************/
 
+#ifndef KATAHIROMZ_VEC2_C
+#define KATAHIROMZ_VEC2_C
+
 #include "vec2.h"
 
-/****************************************************************************/
-/* status checking */
+/****************************************************************************/
+/* status checking */
+
+#ifndef vec2_status_bad
+    #ifdef VEC2_TEST
+        /* the test counts the bad statuses to check the failures */
+        static size_t s_status_bad = 0;
+        #define vec2_status_bad(pv)    (++s_status_bad)
+    #else
+        #define vec2_status_bad(pv)    assert(0)
+    #endif
+#endif
+
+#ifdef VEC2_USE_SSE2
+    #include <emmintrin.h>
+#endif
+#ifdef VEC2_USE_AVX2
+    #include <immintrin.h>
+#endif
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* filling */
+
+/* the limit of the source bytes of pattern doubling, to stay in L1 cache */
+#ifndef VEC2_FILL_CHUNK
+    #define VEC2_FILL_CHUNK     4096
+#endif
+
+/* fills count items at dest with *pitem */
+VEC2_INLINE_FN void
+vec2_fill_items(void *dest, const void *pitem, size_t size_per_item,
+                size_t count)
+{
+    char *p = (char *)dest;
+    size_t total, filled, chunk, limit;
+#ifdef VEC2_USE_SSE2
+    size_t i;
+    char pattern[16];
+    __m128i v;
+#endif
+#ifdef VEC2_USE_AVX2
+    __m256i v2;
+#endif
+
+    total = count * size_per_item;
+    if (total == 0U)
+    {
+        return;
+    }
+
+    if (size_per_item == 1U)
+    {
+        memset(p, *(const unsigned char *)pitem, count);
+        return;
+    }
+
+#ifdef VEC2_USE_SSE2
+    /* broadcast stores for 2, 4, 8 and 16-byte items */
+    if ((size_per_item <= 16U) && ((16U % size_per_item) == 0U) &&
+        (total >= 16U))
+    {
+        for (i = 0; i < 16U; i += size_per_item)
+        {
+            memcpy(&pattern[i], pitem, size_per_item);
+        }
+        v = _mm_loadu_si128((const __m128i *)pattern);
+        i = 0;
+    #ifdef VEC2_USE_AVX2
+        v2 = _mm256_broadcastsi128_si256(v);
+        for (; i + 32U <= total; i += 32U)
+        {
+            _mm256_storeu_si256((__m256i *)&p[i], v2);
+        }
+    #endif
+        for (; i + 16U <= total; i += 16U)
+        {
+            _mm_storeu_si128((__m128i *)&p[i], v);
+        }
+        memcpy(&p[i], pattern, total - i);
+        return;
+    }
+#endif  /* def VEC2_USE_SSE2 */
+
+    /* pattern doubling: copy 1, 2, 4, 8, ... items at a time */
+    memcpy(p, pitem, size_per_item);
+    filled = size_per_item;
+    limit = total;
+    while (filled < total)
+    {
+        chunk = filled;
+        if (chunk > limit)
+        {
+            chunk = limit;
+        }
+        if (chunk > total - filled)
+        {
+            chunk = total - filled;
+        }
+        memcpy(&p[filled], p, chunk);
+        filled += chunk;
+
+        if ((limit == total) && (filled >= VEC2_FILL_CHUNK))
+        {
+            /* keep the source of memcpy small */
+            limit = filled;
+        }
+    }
+} /* vec2_fill_items */
+
+/****************************************************************************/
+/* item copying */
+
+/* copies an item. constant sizes become fixed-size moves. */
+VEC2_INLINE_FN void
+vec2_copy_item(void *dest, const void *src, size_t size_per_item)
+{
+    switch (size_per_item)
+    {
+    case 1:
+        *(char *)dest = *(const char *)src;
+        break;
+    case 2:
+        memcpy(dest, src, 2);
+        break;
+    case 4:
+        memcpy(dest, src, 4);
+        break;
+    case 8:
+        memcpy(dest, src, 8);
+        break;
+    case 16:
+        memcpy(dest, src, 16);
+        break;
+    default:
+        memcpy(dest, src, size_per_item);
+        break;
+    }
+} /* vec2_copy_item */
+
+VEC2_INLINE_FN bool vec2_is_little_endian(void)
+{
+    unsigned short x = 1;
+    return *(const unsigned char *)&x == 1;
+} /* vec2_is_little_endian */
+
+/****************************************************************************/
+/* key scanning */
+
+/* returns the position of the lowest set bit. mask must not be zero. */
+VEC2_INLINE_FN unsigned int vec2_bit_scan(unsigned int mask)
+{
+#ifdef __GNUC__
+    return (unsigned int)__builtin_ctz(mask);
+#else
+    unsigned int n = 0;
+    while ((mask & 1U) == 0U)
+    {
+        mask >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+} /* vec2_bit_scan */
+
+/* stores a match, and returns count when max_indexes are found */
+#define VEC2_SCAN_FOUND_(index) \
+    { \
+        if (indexes != NULL) \
+        { \
+            indexes[count] = (index); \
+        } \
+        if (++count >= max_indexes) \
+        { \
+            return count; \
+        } \
+    }
+
+/*
+ * finds the items at or after index0 whose key equals to the key in one
+ * pass, and returns the number of them (max_indexes at most). it stores
+ * their indexes to indexes unless it's NULL.
+ */
+VEC2_INLINE_FN size_t
+vec2_scan_keys(const char *base, size_t num_items, size_t size_per_item,
+               size_t index0, const void *key, size_t key_offset,
+               size_t key_size, size_t *indexes, size_t max_indexes)
+{
+    size_t i = index0, count = 0;
+    const char *p;
+    unsigned char c;
+#ifdef VEC2_USE_SSE2
+    char pattern[32];
+    const char *q;
+    unsigned int j, bit, m, cand, first_mask, key_mask, shift;
+    size_t step;
+    __m128i vpat;
+    #ifdef VEC2_USE_AVX2
+        __m256i vpat2;
+    #endif
+
+    /* compare 16 (or 32) bytes at once if items don't cross vectors */
+    if ((size_per_item <= 16U) && ((16U % size_per_item) == 0U))
+    {
+        first_mask = 0;
+        for (j = 0; j < 32U; j += (unsigned int)size_per_item)
+        {
+            memset(&pattern[j], 0, size_per_item);
+            memcpy(&pattern[j + key_offset], key, key_size);
+            first_mask |= 1U << (j + key_offset);
+        }
+        key_mask = ((key_size < 32U) ? ((1U << key_size) - 1U) : ~0U);
+        key_mask <<= key_offset;
+
+        /* the item index of a bit is (bit >> shift) */
+        for (shift = 0; (1U << shift) < size_per_item; ++shift)
+        {
+            ;
+        }
+
+    #ifdef VEC2_USE_AVX2
+        vpat2 = _mm256_loadu_si256((const __m256i *)pattern);
+        step = 32U >> shift;
+        for (; i + step <= num_items; i += step)
+        {
+            /* skip 64 bytes at once while there is no candidate */
+            for (; i + 2U * step <= num_items; i += 2U * step)
+            {
+                q = &base[i * size_per_item];
+                m = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(
+                    _mm256_cmpeq_epi8(
+                        _mm256_loadu_si256((const __m256i *)q), vpat2),
+                    _mm256_cmpeq_epi8(
+                        _mm256_loadu_si256((const __m256i *)&q[32]), vpat2)));
+                if ((m & first_mask) != 0U)
+                {
+                    break;
+                }
+            }
+            if (i + step > num_items)
+            {
+                break;
+            }
+
+            m = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+                _mm256_loadu_si256((const __m256i *)&base[i * size_per_item]),
+                vpat2));
+            for (cand = m & first_mask; cand != 0U; cand &= cand - 1U)
+            {
+                bit = vec2_bit_scan(cand) - (unsigned int)key_offset;
+                if (((m >> bit) & key_mask) == key_mask)
+                {
+                    VEC2_SCAN_FOUND_(i + (bit >> shift))
+                }
+            }
+        }
+    #endif  /* def VEC2_USE_AVX2 */
+
+        vpat = _mm_loadu_si128((const __m128i *)pattern);
+        first_mask &= 0xFFFFU;
+        step = 16U >> shift;
+        for (; i + step <= num_items; i += step)
+        {
+            /* skip 64 bytes at once while there is no candidate */
+            for (; i + 4U * step <= num_items; i += 4U * step)
+            {
+                q = &base[i * size_per_item];
+                m = (unsigned int)_mm_movemask_epi8(_mm_or_si128(
+                    _mm_or_si128(
+                        _mm_cmpeq_epi8(
+                            _mm_loadu_si128((const __m128i *)q), vpat),
+                        _mm_cmpeq_epi8(
+                            _mm_loadu_si128((const __m128i *)&q[16]), vpat)),
+                    _mm_or_si128(
+                        _mm_cmpeq_epi8(
+                            _mm_loadu_si128((const __m128i *)&q[32]), vpat),
+                        _mm_cmpeq_epi8(
+                            _mm_loadu_si128((const __m128i *)&q[48]), vpat))));
+                if ((m & first_mask) != 0U)
+                {
+                    break;
+                }
+            }
+            if (i + step > num_items)
+            {
+                break;
+            }
+
+            m = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128((const __m128i *)&base[i * size_per_item]),
+                vpat));
+            for (cand = m & first_mask; cand != 0U; cand &= cand - 1U)
+            {
+                bit = vec2_bit_scan(cand) - (unsigned int)key_offset;
+                if (((m >> bit) & key_mask) == key_mask)
+                {
+                    VEC2_SCAN_FOUND_(i + (bit >> shift))
+                }
+            }
+        }
+    }
+#endif  /* def VEC2_USE_SSE2 */
+
+    /* NOTE: memcmp with a constant size becomes a single load and compare. */
+    p = &base[i * size_per_item + key_offset];
+    switch (key_size)
+    {
+    case 1:
+        c = *(const unsigned char *)key;
+        for (; i < num_items; ++i, p += size_per_item)
+        {
+            if (*(const unsigned char *)p == c)
+            {
+                VEC2_SCAN_FOUND_(i)
+            }
+        }
+        break;
+    case 2:
+        for (; i < num_items; ++i, p += size_per_item)
+        {
+            if (memcmp(p, key, 2) == 0)
+            {
+                VEC2_SCAN_FOUND_(i)
+            }
+        }
+        break;
+    case 4:
+        for (; i < num_items; ++i, p += size_per_item)
+        {
+            if (memcmp(p, key, 4) == 0)
+            {
+                VEC2_SCAN_FOUND_(i)
+            }
+        }
+        break;
+    case 8:
+        for (; i < num_items; ++i, p += size_per_item)
+        {
+            if (memcmp(p, key, 8) == 0)
+            {
+                VEC2_SCAN_FOUND_(i)
+            }
+        }
+        break;
+    default:
+        for (; i < num_items; ++i, p += size_per_item)
+        {
+            if (memcmp(p, key, key_size) == 0)
+            {
+                VEC2_SCAN_FOUND_(i)
+            }
+        }
+        break;
+    }
+
+    return count;
+} /* vec2_scan_keys */
+
+/* returns the index of the first item at or after index0 whose key equals
+   to the key, or VEC2_NPOS */
+VEC2_INLINE_FN size_t
+vec2_scan_key(const char *base, size_t num_items, size_t size_per_item,
+              size_t index0, const void *key, size_t key_offset,
+              size_t key_size)
+{
+    size_t i;
+    if (vec2_scan_keys(base, num_items, size_per_item, index0, key,
+                       key_offset, key_size, &i, 1) == 0U)
+    {
+        return VEC2_NPOS;
+    }
+    return i;
+} /* vec2_scan_key */
+
+/****************************************************************************/
+/* functions */
+
+VEC2_API bool vec2_valid(const VEC2 *pv)
+{
+    bool ret;
+
+    if ((pv == NULL) || (pv->num_items > pv->capacity))
+    {
+        ret = false;
+    }
+    else if ((pv->num_items != 0U) && (pv->items == NULL))
+    {
+        ret = false;
+    }
+    else if (pv->size_per_item == 0U)
+    {
+        ret = false;
+    }
+    else
+    {
+        ret = true;
+    }
+
+    return ret;
+} /* vec2_valid */
+
+#ifndef NDEBUG
+    VEC2_API void *vec2_item(PVEC2 pv, size_t index0)
+    {
+        char *p;
+        assert(vec2_valid(pv));
+        assert(index0 <= vec2_size(pv));
+        p = (char *)pv->items;
+        return (void *)(p + index0 * pv->size_per_item);
+    } /* vec2_item */
+
+    VEC2_API const void *vec2_const_item(const VEC2 *pv, size_t index0)
+    {
+        const char *p;
+        assert(vec2_valid(pv));
+        assert(index0 <= vec2_size(pv));
+        p = (const char *)pv->items;
+        return (const void *)(p + index0 * pv->size_per_item);
+    } /* vec2_const_item */
+#endif  /* ndef NDEBUG */
+
+VEC2_API vec2_bool
+vec2_construct(PVEC2 pv, size_t size_per_item,
+               size_t capacity, void *items, size_t num_items)
+{
+    VEC2_STATUS_INIT(ret, true);
+    assert(items != NULL);
+
+    /* NOTE: vec2 doesn't allocate memory. Just weakly refers. */
+    pv->items = items;
+    pv->size_per_item = size_per_item;
+    pv->num_items = num_items;
+    pv->capacity = capacity;
+#ifdef VEC2_DIRTY_TRACKING
+    pv->dirty = NULL;
+    pv->dirty_shift = 0;
+#endif
+
+    assert(vec2_valid(pv));
+
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_construct */
+
+VEC2_API void vec2_destroy(PVEC2 pv)
+{
+    assert(vec2_valid(pv));
+    /* NOTE: vec2 doesn't free memory. */
+} /* vec2_destroy */
+
+VEC2_API void vec2_clear(PVEC2 pv)
+{
+    assert(vec2_valid(pv));
+    vec2_destroy(pv);
+    pv->num_items = 0;
+} /* vec2_clear */
+
+VEC2_API void *vec2_get_at(PVEC2 pv, size_t index0)
+{
+    char *ptr;
+    void *p = NULL;
+    assert(vec2_valid(pv));
+    assert(index0 <= pv->num_items);
+    if (index0 <= pv->num_items)
+    {
+        ptr = (char *)pv->items;
+        p = &ptr[index0 * pv->size_per_item];
+    }
+    return p;
+} /* vec2_get_at */
+
+VEC2_API void vec2_set_at(PVEC2 pv, size_t index0, const void *pitem)
+{
+    void *p;
+    assert(vec2_valid(pv));
+    p = vec2_get_at(pv, index0);
+    if (p != NULL)
+    {
+        memcpy(p, pitem, pv->size_per_item);
+        vec2_mark_dirty(pv, index0, 1);
+    }
+    assert(vec2_valid(pv));
+} /* vec2_set_at */
+
+#ifndef MISRA_C
+    /* NOTE: vec2_bsearch() and vec2_sort() aren't available in MISRA-C. */
+
+    VEC2_API void *
+    vec2_bsearch(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare)
+    {
+        assert(vec2_valid(pv));
+        assert(pitem != NULL);
+        assert(compare != NULL);
+        return bsearch(pitem, pv->items, pv->num_items,
+                       pv->size_per_item, compare);
+    } /* vec2_bsearch */
+
+    VEC2_API void vec2_sort(PVEC2 pv, VEC2_ITEM_COMPARE_FN compare)
+    {
+        assert(vec2_valid(pv));
+        assert(compare != NULL);
+        qsort(pv->items, pv->num_items, pv->size_per_item, compare);
+        vec2_mark_dirty(pv, 0, pv->num_items);
+    } /* vec2_sort */
+#endif  /* ndef MISRA_C */
+
+#define VEC2_KEY_COMPARE_AS_(T,a,b) \
+    { \
+        T x_, y_; \
+        memcpy(&x_, (a), sizeof(T)); \
+        memcpy(&y_, (b), sizeof(T)); \
+        return (x_ > y_) - (x_ < y_); \
+    }
+
+/* NOTE: A float key is compared by the bits as vec2_radix_sort() orders
+ *       them, not by the value. -0.0 is before +0.0, and the NaNs are at
+ *       the ends. */
+#define VEC2_KEY_COMPARE_FLOAT_(U,a,b) \
+    { \
+        U x_, y_, sign_ = (U)1 << (sizeof(U) * 8U - 1U); \
+        memcpy(&x_, (a), sizeof(U)); \
+        memcpy(&y_, (b), sizeof(U)); \
+        x_ ^= (x_ & sign_) ? ~(U)0 : sign_; \
+        y_ ^= (y_ & sign_) ? ~(U)0 : sign_; \
+        return (x_ > y_) - (x_ < y_); \
+    }
+
+/* compares the keys a and b in the order of vec2_sort_by_key() */
+VEC2_INLINE_FN int
+vec2_key_compare(const void *a, const void *b, size_t key_size,
+                 VEC2_KEY_TYPE key_type)
+{
+    const unsigned char *p = (const unsigned char *)a;
+    const unsigned char *q = (const unsigned char *)b;
+    unsigned int x, y, neg_x, neg_y;
+    size_t i, pos;
+
+    switch (key_type)
+    {
+    case VEC2_KEY_UNSIGNED:
+        if (key_size == sizeof(unsigned int))
+            VEC2_KEY_COMPARE_AS_(unsigned int, a, b)
+        if (key_size == sizeof(unsigned long))
+            VEC2_KEY_COMPARE_AS_(unsigned long, a, b)
+        if (key_size == sizeof(unsigned short))
+            VEC2_KEY_COMPARE_AS_(unsigned short, a, b)
+        if (key_size == 1U)
+            VEC2_KEY_COMPARE_AS_(unsigned char, a, b)
+        break;
+    case VEC2_KEY_SIGNED:
+        if (key_size == sizeof(int))
+            VEC2_KEY_COMPARE_AS_(int, a, b)
+        if (key_size == sizeof(long))
+            VEC2_KEY_COMPARE_AS_(long, a, b)
+        if (key_size == sizeof(short))
+            VEC2_KEY_COMPARE_AS_(short, a, b)
+        if (key_size == 1U)
+            VEC2_KEY_COMPARE_AS_(signed char, a, b)
+        break;
+    case VEC2_KEY_FLOAT:
+        if (key_size == sizeof(unsigned int))
+            VEC2_KEY_COMPARE_FLOAT_(unsigned int, a, b)
+        if (key_size == sizeof(unsigned long))
+            VEC2_KEY_COMPARE_FLOAT_(unsigned long, a, b)
+        break;
+    case VEC2_KEY_BYTES:
+        if (key_size == 1U)
+        {
+            return (int)*p - (int)*q;
+        }
+        return memcmp(a, b, key_size);
+    }
+
+    /* byte by byte from the most significant one */
+    neg_x = neg_y = 0;
+    if (key_type == VEC2_KEY_FLOAT)
+    {
+        pos = vec2_is_little_endian() ? key_size - 1U : 0U;
+        neg_x = (p[pos] & 0x80) ? 0xFF : 0x00;
+        neg_y = (q[pos] & 0x80) ? 0xFF : 0x00;
+    }
+    for (i = 0; i < key_size; ++i)
+    {
+        pos = vec2_is_little_endian() ? key_size - 1U - i : i;
+        x = p[pos] ^ neg_x;
+        y = q[pos] ^ neg_y;
+        if ((i == 0U) && (key_type != VEC2_KEY_UNSIGNED))
+        {
+            x ^= (neg_x ? 0x00 : 0x80);
+            y ^= (neg_y ? 0x00 : 0x80);
+        }
+        if (x != y)
+        {
+            return (x < y) ? -1 : 1;
+        }
+    }
+    return 0;
+} /* vec2_key_compare */
+
+/*
+ * the branchless binary search.
+ * it returns the number of the items whose comparison is less than limit.
+ * NOTE: limit is 0 for the lower bound and 1 for the upper bound.
+ */
+VEC2_INLINE_FN size_t
+vec2_bound(const VEC2 *pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare,
+           int limit)
+{
+    const char *items = (const char *)pv->items;
+    const char *base = items;
+    size_t n = pv->num_items, half, size_per_item = pv->size_per_item;
+
+    if (n == 0U)
+    {
+        return 0;
+    }
+    while (n > 1U)
+    {
+        half = n / 2;
+        /* both of the next probes */
+        VEC2_PREFETCH(&base[(half / 2) * size_per_item]);
+        VEC2_PREFETCH(&base[(half + half / 2) * size_per_item]);
+        base = ((*compare)(&base[half * size_per_item], pitem) < limit) ?
+               &base[half * size_per_item] : base;
+        n -= half;
+    }
+    return (size_t)(base - items) / size_per_item +
+           ((*compare)(base, pitem) < limit);
+} /* vec2_bound */
+
+VEC2_INLINE_FN size_t
+vec2_bound_key(const VEC2 *pv, const void *key, size_t key_offset,
+               size_t key_size, VEC2_KEY_TYPE key_type, int limit)
+{
+    const char *items = (const char *)pv->items;
+    const char *base = items;
+    size_t n = pv->num_items, half, size_per_item = pv->size_per_item;
+
+    if (n == 0U)
+    {
+        return 0;
+    }
+    while (n > 1U)
+    {
+        half = n / 2;
+        VEC2_PREFETCH(&base[(half / 2) * size_per_item + key_offset]);
+        VEC2_PREFETCH(&base[(half + half / 2) * size_per_item + key_offset]);
+        base = (vec2_key_compare(&base[half * size_per_item + key_offset],
+                                 key, key_size, key_type) < limit) ?
+               &base[half * size_per_item] : base;
+        n -= half;
+    }
+    return (size_t)(base - items) / size_per_item +
+           (vec2_key_compare(&base[key_offset], key, key_size,
+                             key_type) < limit);
+} /* vec2_bound_key */
+
+/* returns floor(log2(n)). n must not be zero. */
+VEC2_INLINE_FN size_t vec2_log2(size_t n)
+{
+    size_t r = 0;
+#ifdef __GNUC__
+    if (sizeof(size_t) <= sizeof(unsigned long))
+    {
+        return sizeof(unsigned long) * 8U - 1U -
+               (size_t)__builtin_clzl((unsigned long)n);
+    }
+#endif
+    while (n > 1U)
+    {
+        n >>= 1;
+        ++r;
+    }
+    return r;
+} /* vec2_log2 */
+
+/* returns the number of the trailing one bits of n */
+VEC2_INLINE_FN size_t vec2_trailing_ones(size_t n)
+{
+    size_t r = 0;
+#ifdef __GNUC__
+    if (sizeof(size_t) <= sizeof(unsigned long) && ~n != 0U)
+    {
+        return (size_t)__builtin_ctzl((unsigned long)~n);
+    }
+#endif
+    while (n & 1U)
+    {
+        n >>= 1;
+        ++r;
+    }
+    return r;
+} /* vec2_trailing_ones */
+
+/*
+ * the sorted index of the Eytzinger slot k (1-based) of n items.
+ * the slots form a complete binary tree of levels = log2(n) + 1. in the
+ * perfect tree of the same levels, the in-order position of k follows from
+ * its depth; the leaves missing from the last level are subtracted.
+ */
+VEC2_INLINE_FN size_t vec2_eytz_rank(size_t k, size_t n)
+{
+    size_t depth = vec2_log2(k), height = vec2_log2(n);
+    size_t leaves = n + 1U - ((size_t)1 << height);
+    size_t pos;
+
+    pos = ((2U * (k - ((size_t)1 << depth)) + 1U) << (height - depth)) - 1U;
+    if (pos > 2U * leaves)
+    {
+        pos -= (pos - 2U * leaves + 1U) / 2U;
+    }
+    return pos;
+} /* vec2_eytz_rank */
+
+/* the Eytzinger slot of the sorted index (the inverse of vec2_eytz_rank) */
+VEC2_INLINE_FN size_t vec2_eytz_slot(size_t index0, size_t n)
+{
+    size_t height = vec2_log2(n);
+    size_t leaves = n + 1U - ((size_t)1 << height);
+    size_t pos = index0, zeros;
+
+    if (index0 >= 2U * leaves)
+    {
+        pos = 2U * index0 - 2U * leaves + 1U;
+    }
+    zeros = vec2_trailing_ones(~(pos + 1U));
+    return ((pos + 1U) >> (zeros + 1U)) +
+           ((size_t)1 << (height - zeros));
+} /* vec2_eytz_slot */
+
+/* the number of the levels to prefetch ahead, so that the descendants
+   fill a cache line. large items prefetch two levels ahead. */
+VEC2_INLINE_FN size_t vec2_eytz_ahead(size_t size_per_item)
+{
+    size_t ahead = 2;
+    while (ahead < 4U && ((size_t)2 << ahead) * size_per_item <= 64U)
+    {
+        ++ahead;
+    }
+    return ahead;
+} /* vec2_eytz_ahead */
+
+/* prefetches the descendants of ahead levels below the slot k, one cache
+   line per line or per item (the first line of each large item) */
+#define VEC2_EYTZ_PREFETCH(items, k, ahead, size_per_item) do { \
+    const char *vec2_p_ = &(items)[((k) << (ahead)) * (size_per_item)]; \
+    size_t vec2_i_ = ((size_per_item) << (ahead)); \
+    size_t vec2_step_ = ((size_per_item) > 64U) ? (size_per_item) : 64U; \
+    VEC2_PREFETCH(vec2_p_); \
+    while (vec2_i_ > vec2_step_) { \
+        vec2_i_ -= vec2_step_; \
+        VEC2_PREFETCH(&vec2_p_[vec2_i_]); \
+    } \
+} while (0)
+
+/*
+ * the branchless Eytzinger search. the comparison of each level only
+ * chooses the child; the slot of the result is restored from the path
+ * at the end. it returns the sorted index like vec2_bound().
+ */
+VEC2_INLINE_FN size_t
+vec2_eytz_bound(const VEC2 *pv, const void *pitem,
+                VEC2_ITEM_COMPARE_FN compare, int limit)
+{
+    const char *items = (const char *)pv->items;
+    size_t n = pv->num_items - 1U, k = 1, size_per_item = pv->size_per_item;
+    size_t ahead = vec2_eytz_ahead(size_per_item);
+
+    while ((k << ahead) <= n)
+    {
+        VEC2_EYTZ_PREFETCH(items, k, ahead, size_per_item);
+        k = 2U * k +
+            ((*compare)(&items[k * size_per_item], pitem) < limit);
+    }
+    while (k <= n)
+    {
+        k = 2U * k +
+            ((*compare)(&items[k * size_per_item], pitem) < limit);
+    }
+    k >>= vec2_trailing_ones(k) + 1U;
+    return (k == 0U) ? n : vec2_eytz_rank(k, n);
+} /* vec2_eytz_bound */
+
+VEC2_INLINE_FN size_t
+vec2_eytz_bound_key(const VEC2 *pv, const void *key, size_t key_offset,
+                    size_t key_size, VEC2_KEY_TYPE key_type, int limit)
+{
+    const char *items = (const char *)pv->items + key_offset;
+    size_t n = pv->num_items - 1U, k = 1, size_per_item = pv->size_per_item;
+    size_t ahead = vec2_eytz_ahead(size_per_item);
+
+    while ((k << ahead) <= n)
+    {
+        VEC2_EYTZ_PREFETCH(items, k, ahead, size_per_item);
+        k = 2U * k + (vec2_key_compare(&items[k * size_per_item], key,
+                                       key_size, key_type) < limit);
+    }
+    while (k <= n)
+    {
+        k = 2U * k + (vec2_key_compare(&items[k * size_per_item], key,
+                                       key_size, key_type) < limit);
+    }
+    k >>= vec2_trailing_ones(k) + 1U;
+    return (k == 0U) ? n : vec2_eytz_rank(k, n);
+} /* vec2_eytz_bound_key */
+
+VEC2_API size_t
+vec2_lower_bound(const VEC2 *pv, const void *pitem,
+                 VEC2_ITEM_COMPARE_FN compare)
+{
+    assert(vec2_valid(pv));
+    assert(pitem != NULL);
+    assert(compare != NULL);
+    return vec2_bound(pv, pitem, compare, 0);
+} /* vec2_lower_bound */
+
+VEC2_API size_t
+vec2_upper_bound(const VEC2 *pv, const void *pitem,
+                 VEC2_ITEM_COMPARE_FN compare)
+{
+    assert(vec2_valid(pv));
+    assert(pitem != NULL);
+    assert(compare != NULL);
+    return vec2_bound(pv, pitem, compare, 1);
+} /* vec2_upper_bound */
+
+VEC2_API size_t
+vec2_equal_range(const VEC2 *pv, const void *pitem,
+                 VEC2_ITEM_COMPARE_FN compare, size_t *pcount)
+{
+    size_t first;
+
+    assert(vec2_valid(pv));
+    assert(pitem != NULL);
+    assert(compare != NULL);
+    assert(pcount != NULL);
+
+    first = vec2_bound(pv, pitem, compare, 0);
+    *pcount = vec2_bound(pv, pitem, compare, 1) - first;
+    return first;
+} /* vec2_equal_range */
+
+VEC2_API size_t
+vec2_lower_bound_key(const VEC2 *pv, const void *key, size_t key_offset,
+                     size_t key_size, VEC2_KEY_TYPE key_type)
+{
+    assert(vec2_valid(pv));
+    assert(key != NULL);
+    assert(key_offset + key_size <= pv->size_per_item);
+    return vec2_bound_key(pv, key, key_offset, key_size, key_type, 0);
+} /* vec2_lower_bound_key */
+
+VEC2_API size_t
+vec2_upper_bound_key(const VEC2 *pv, const void *key, size_t key_offset,
+                     size_t key_size, VEC2_KEY_TYPE key_type)
+{
+    assert(vec2_valid(pv));
+    assert(key != NULL);
+    assert(key_offset + key_size <= pv->size_per_item);
+    return vec2_bound_key(pv, key, key_offset, key_size, key_type, 1);
+} /* vec2_upper_bound_key */
+
+VEC2_API size_t
+vec2_equal_range_key(const VEC2 *pv, const void *key, size_t key_offset,
+                     size_t key_size, VEC2_KEY_TYPE key_type,
+                     size_t *pcount)
+{
+    size_t first;
+
+    assert(vec2_valid(pv));
+    assert(key != NULL);
+    assert(key_offset + key_size <= pv->size_per_item);
+    assert(pcount != NULL);
+
+    first = vec2_bound_key(pv, key, key_offset, key_size, key_type, 0);
+    *pcount = vec2_bound_key(pv, key, key_offset, key_size, key_type, 1) -
+              first;
+    return first;
+} /* vec2_equal_range_key */
+
+VEC2_API vec2_bool
+vec2_insert_sorted(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare)
+{
+    char *ptr;
+    size_t index0;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(pv));
+    assert(pitem != NULL);
+    assert(compare != NULL);
+
+    if (pv->num_items < pv->capacity)
+    {
+        index0 = vec2_bound(pv, pitem, compare, 1);
+        ptr = (char *)pv->items;
+        memmove(&ptr[(index0 + 1) * pv->size_per_item],
+                &ptr[index0 * pv->size_per_item],
+                (pv->num_items - index0) * pv->size_per_item);
+        memcpy(&ptr[index0 * pv->size_per_item], pitem, pv->size_per_item);
+        pv->num_items += 1U;
+        vec2_mark_dirty(pv, index0, pv->num_items - index0);
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(pv);
+    }
+
+    assert(vec2_valid(pv));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_insert_sorted */
+
+VEC2_API size_t
+vec2_erase_key(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare)
+{
+    char *ptr;
+    size_t first, last;
+
+    assert(vec2_valid(pv));
+    assert(pitem != NULL);
+    assert(compare != NULL);
+
+    first = vec2_bound(pv, pitem, compare, 0);
+    last = first;
+    if ((first < pv->num_items) &&
+        ((*compare)(vec2_const_item(pv, first), pitem) == 0))
+    {
+        last = vec2_bound(pv, pitem, compare, 1);
+        ptr = (char *)pv->items;
+        memmove(&ptr[first * pv->size_per_item],
+                &ptr[last * pv->size_per_item],
+                (pv->num_items - last) * pv->size_per_item);
+        pv->num_items -= last - first;
+        vec2_mark_dirty(pv, first, pv->num_items - first);
+    }
+
+    assert(vec2_valid(pv));
+    return last - first;
+} /* vec2_erase_key */
+
+VEC2_API vec2_bool vec2_eytz_build(PVEC2 dest, const VEC2 *src)
+{
+    char *p;
+    const char *q;
+    size_t k, n, size_per_item;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(dest));
+    assert(vec2_valid(src));
+    assert(dest != src);
+    assert(dest->size_per_item == src->size_per_item);
+
+    n = src->num_items;
+    if (n < dest->capacity)
+    {
+        p = (char *)dest->items;
+        q = (const char *)src->items;
+        size_per_item = src->size_per_item;
+        memset(p, 0, size_per_item);
+        for (k = 1; k <= n; ++k)
+        {
+            vec2_copy_item(&p[k * size_per_item],
+                           &q[vec2_eytz_rank(k, n) * size_per_item],
+                           size_per_item);
+        }
+        dest->num_items = n + 1U;
+        vec2_mark_dirty(dest, 0, dest->num_items);
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(dest);
+    }
+
+    assert(vec2_valid(dest));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_eytz_build */
+
+VEC2_API size_t
+vec2_eytz_lower_bound(const VEC2 *pv, const void *pitem,
+                      VEC2_ITEM_COMPARE_FN compare)
+{
+    assert(vec2_valid(pv));
+    assert(pv->num_items > 0U);
+    assert(pitem != NULL);
+    assert(compare != NULL);
+    return vec2_eytz_bound(pv, pitem, compare, 0);
+} /* vec2_eytz_lower_bound */
+
+VEC2_API size_t
+vec2_eytz_upper_bound(const VEC2 *pv, const void *pitem,
+                      VEC2_ITEM_COMPARE_FN compare)
+{
+    assert(vec2_valid(pv));
+    assert(pv->num_items > 0U);
+    assert(pitem != NULL);
+    assert(compare != NULL);
+    return vec2_eytz_bound(pv, pitem, compare, 1);
+} /* vec2_eytz_upper_bound */
+
+VEC2_API size_t
+vec2_eytz_lower_bound_key(const VEC2 *pv, const void *key,
+                          size_t key_offset, size_t key_size,
+                          VEC2_KEY_TYPE key_type)
+{
+    assert(vec2_valid(pv));
+    assert(pv->num_items > 0U);
+    assert(key != NULL);
+    assert(key_offset + key_size <= pv->size_per_item);
+    return vec2_eytz_bound_key(pv, key, key_offset, key_size, key_type, 0);
+} /* vec2_eytz_lower_bound_key */
+
+VEC2_API size_t
+vec2_eytz_upper_bound_key(const VEC2 *pv, const void *key,
+                          size_t key_offset, size_t key_size,
+                          VEC2_KEY_TYPE key_type)
+{
+    assert(vec2_valid(pv));
+    assert(pv->num_items > 0U);
+    assert(key != NULL);
+    assert(key_offset + key_size <= pv->size_per_item);
+    return vec2_eytz_bound_key(pv, key, key_offset, key_size, key_type, 1);
+} /* vec2_eytz_upper_bound_key */
+
+VEC2_API void *vec2_eytz_at(PVEC2 pv, size_t index0)
+{
+    assert(vec2_valid(pv));
+    assert(index0 + 1U < pv->num_items);
+    return vec2_item(pv, vec2_eytz_slot(index0, pv->num_items - 1U));
+} /* vec2_eytz_at */
+
+/* the number of radix passes counted in one histogram pass */
+#ifndef VEC2_RADIX_GROUP
+    #define VEC2_RADIX_GROUP    8
+#endif
+
+/* sorts n items by radix. the result is in items. */
+VEC2_INLINE_FN void
+vec2_radix_sort(char *items, char *scratch, size_t n, size_t size_per_item,
+                size_t key_offset, size_t key_size, VEC2_KEY_TYPE key_type)
+{
+    size_t counts[VEC2_RADIX_GROUP][256];
+    size_t pos[VEC2_RADIX_GROUP];
+    unsigned int flip[VEC2_RADIX_GROUP], neg_flip[VEC2_RADIX_GROUP];
+    size_t i, g, k, pass, num_passes, msb, sum, count;
+    unsigned int digit;
+    const unsigned char *q;
+    char *src, *dest, *tmp;
+
+    /* the offset of the most significant byte in the item */
+    if ((key_type == VEC2_KEY_BYTES) || !vec2_is_little_endian())
+    {
+        msb = key_offset;
+    }
+    else
+    {
+        msb = key_offset + key_size - 1U;
+    }
+
+    src = items;
+    dest = scratch;
+    for (pass = 0; pass < key_size; pass += VEC2_RADIX_GROUP)
+    {
+        /* the digits of the passes, least significant first */
+        num_passes = key_size - pass;
+        if (num_passes > VEC2_RADIX_GROUP)
+        {
+            num_passes = VEC2_RADIX_GROUP;
+        }
+        for (g = 0; g < num_passes; ++g)
+        {
+            if (msb == key_offset)
+            {
+                pos[g] = key_offset + key_size - 1U - (pass + g);
+            }
+            else
+            {
+                pos[g] = key_offset + pass + g;
+            }
+
+            /* signed: flip the sign bit.
+               float: flip the sign bit if positive, all bits if negative. */
+            flip[g] = 0;
+            neg_flip[g] = 0;
+            if ((key_type == VEC2_KEY_SIGNED) || (key_type == VEC2_KEY_FLOAT))
+            {
+                if (pos[g] == msb)
+                {
+                    flip[g] = 0x80;
+                }
+            }
+            if (key_type == VEC2_KEY_FLOAT)
+            {
+                neg_flip[g] = 0xFF ^ flip[g];
+            }
+        }
+
+        /* the histograms don't depend on the order of the items */
+        memset(counts, 0, sizeof(counts));
+        for (i = 0; i < n; ++i)
+        {
+            q = (const unsigned char *)&src[i * size_per_item];
+            for (g = 0; g < num_passes; ++g)
+            {
+                digit = q[pos[g]] ^ flip[g] ^ ((q[msb] >> 7) * neg_flip[g]);
+                ++counts[g][digit];
+            }
+        }
+
+        for (g = 0; g < num_passes; ++g)
+        {
+            /* skip the pass if all the digits are the same */
+            q = (const unsigned char *)src;
+            digit = q[pos[g]] ^ flip[g] ^ ((q[msb] >> 7) * neg_flip[g]);
+            if (counts[g][digit] == n)
+            {
+                continue;
+            }
+
+            /* the start positions */
+            sum = 0;
+            for (k = 0; k < 256U; ++k)
+            {
+                count = counts[g][k];
+                counts[g][k] = sum;
+                sum += count;
+            }
+
+            /* scatter */
+            for (i = 0; i < n; ++i)
+            {
+                q = (const unsigned char *)&src[i * size_per_item];
+                digit = q[pos[g]] ^ flip[g] ^ ((q[msb] >> 7) * neg_flip[g]);
+                vec2_copy_item(&dest[counts[g][digit] * size_per_item], q,
+                               size_per_item);
+                ++counts[g][digit];
+            }
+
+            tmp = src;
+            src = dest;
+            dest = tmp;
+        }
+    }
+
+    if (src != items)
+    {
+        memcpy(items, src, n * size_per_item);
+    }
+} /* vec2_radix_sort */
+
+VEC2_API vec2_bool
+vec2_sort_by_key(PVEC2 pv, size_t key_offset, size_t key_size,
+                 VEC2_KEY_TYPE key_type, PVEC2 scratch)
+{
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(pv));
+    assert(vec2_valid(scratch));
+    assert(key_size > 0U);
+    assert(key_offset + key_size <= pv->size_per_item);
+    assert((key_type != VEC2_KEY_FLOAT) || (key_size == 4U) ||
+           (key_size == 8U));
+    assert(pv->items != scratch->items);
+
+    if (scratch->capacity * scratch->size_per_item <
+        pv->num_items * pv->size_per_item)
+    {
+        /* status bad */
+        vec2_status_bad(pv);
+    }
+    else
+    {
+        if (pv->num_items > 1U)
+        {
+            vec2_radix_sort((char *)pv->items, (char *)scratch->items,
+                            pv->num_items, pv->size_per_item,
+                            key_offset, key_size, key_type);
+            vec2_mark_dirty(pv, 0, pv->num_items);
+        }
+        VEC2_STATUS_SET(ret, true);
+    }
+
+    assert(vec2_valid(pv));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_sort_by_key */
+
+/* the run length of vec2_stable_sort() */
+#ifndef VEC2_STABLE_RUN
+    #define VEC2_STABLE_RUN     8
+#endif
+
+/* merges the sorted runs a (na items) and b (nb items) into dest */
+VEC2_INLINE_FN void
+vec2_merge_items(char *dest, const char *a, size_t na, const char *b,
+                 size_t nb, size_t size_per_item, VEC2_ITEM_COMPARE_FN compare)
+{
+    const char *a_end = a + na * size_per_item;
+    const char *b_end = b + nb * size_per_item;
+    const char *run;
+
+    if ((na > 0U) && (nb > 0U) &&
+        ((*compare)(a_end - size_per_item, b) <= 0))
+    {
+        /* already in order */
+        memcpy(dest, a, na * size_per_item);
+        memcpy(&dest[na * size_per_item], b, nb * size_per_item);
+        return;
+    }
+
+    while ((a != a_end) && (b != b_end))
+    {
+        /* copy the run of a that is not greater than *b at once */
+        run = a;
+        while ((a != a_end) && ((*compare)(a, b) <= 0))
+        {
+            a += size_per_item;
+        }
+        memcpy(dest, run, (size_t)(a - run));
+        dest += a - run;
+        if (a == a_end)
+        {
+            break;
+        }
+
+        /* copy the run of b that is less than *a at once */
+        run = b;
+        while ((b != b_end) && ((*compare)(b, a) < 0))
+        {
+            b += size_per_item;
+        }
+        memcpy(dest, run, (size_t)(b - run));
+        dest += b - run;
+    }
+    memcpy(dest, a, (size_t)(a_end - a));
+    dest += a_end - a;
+    memcpy(dest, b, (size_t)(b_end - b));
+} /* vec2_merge_items */
+
+/* stable-sorts n items. the result is in items. */
+VEC2_INLINE_FN void
+vec2_merge_sort(char *items, char *scratch, size_t n, size_t size_per_item,
+                VEC2_ITEM_COMPARE_FN compare)
+{
+    size_t i, j, k, m, width, na, nb;
+    char *src, *dest, *tmp;
+
+    /* insertion-sort the runs into scratch */
+    for (i = 0; i < n; i += VEC2_STABLE_RUN)
+    {
+        m = n - i;
+        if (m > VEC2_STABLE_RUN)
+        {
+            m = VEC2_STABLE_RUN;
+        }
+        dest = &scratch[i * size_per_item];
+        for (j = 0; j < m; ++j)
+        {
+            src = &items[(i + j) * size_per_item];
+            for (k = j; k > 0U; --k)
+            {
+                if ((*compare)(&dest[(k - 1) * size_per_item], src) <= 0)
+                {
+                    break;
+                }
+            }
+            memmove(&dest[(k + 1) * size_per_item], &dest[k * size_per_item],
+                    (j - k) * size_per_item);
+            vec2_copy_item(&dest[k * size_per_item], src, size_per_item);
+        }
+    }
+
+    /* merge the runs */
+    src = scratch;
+    dest = items;
+    for (width = VEC2_STABLE_RUN; width < n; width *= 2)
+    {
+        for (i = 0; i < n; i += 2 * width)
+        {
+            na = n - i;
+            if (na > width)
+            {
+                na = width;
+            }
+            nb = n - i - na;
+            if (nb > width)
+            {
+                nb = width;
+            }
+            vec2_merge_items(&dest[i * size_per_item], &src[i * size_per_item],
+                             na, &src[(i + na) * size_per_item], nb,
+                             size_per_item, compare);
+        }
+        tmp = src;
+        src = dest;
+        dest = tmp;
+    }
+
+    if (src != items)
+    {
+        memcpy(items, src, n * size_per_item);
+    }
+} /* vec2_merge_sort */
+
+VEC2_API vec2_bool
+vec2_stable_sort(PVEC2 pv, VEC2_ITEM_COMPARE_FN compare, PVEC2 scratch)
+{
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(pv));
+    assert(vec2_valid(scratch));
+    assert(compare != NULL);
+    assert(pv->items != scratch->items);
+
+    if (scratch->capacity * scratch->size_per_item <
+        pv->num_items * pv->size_per_item)
+    {
+        /* status bad */
+        vec2_status_bad(pv);
+    }
+    else
+    {
+        vec2_merge_sort((char *)pv->items, (char *)scratch->items,
+                        pv->num_items, pv->size_per_item, compare);
+        vec2_mark_dirty(pv, 0, pv->num_items);
+        VEC2_STATUS_SET(ret, true);
+    }
+
+    assert(vec2_valid(pv));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_stable_sort */
+
+/* the items that vec2_set_op() outputs */
+#define VEC2_SET_A      1   /* the items only in a */
+#define VEC2_SET_B      2   /* the items only in b */
+#define VEC2_SET_BOTH   4   /* the items in both a and b (taken from a) */
+
+/* outputs the run of size bytes if dest has room */
+VEC2_INLINE_FN bool
+vec2_set_put(char **pout, size_t *proom, const char *run, size_t size)
+{
+    if (size > *proom)
+    {
+        return false;
+    }
+    memcpy(*pout, run, size);
+    *pout += size;
+    *proom -= size;
+    return true;
+} /* vec2_set_put */
+
+/* streams a and b once and copies the runs that flags chooses to dest */
+VEC2_INLINE_FN bool
+vec2_set_op(PVEC2 dest, const VEC2 *a, const VEC2 *b,
+            VEC2_ITEM_COMPARE_FN compare, int flags)
+{
+    size_t size_per_item = dest->size_per_item;
+    const char *p = (const char *)a->items;
+    const char *p_end = p + a->num_items * size_per_item;
+    const char *q = (const char *)b->items;
+    const char *q_end = q + b->num_items * size_per_item;
+    const char *run;
+    char *out = (char *)dest->items;
+    size_t room = dest->capacity * size_per_item;
+    bool ok = true;
+
+    while (ok && (p != p_end) && (q != q_end))
+    {
+        /* the run of a less than *q */
+        run = p;
+        while ((p != p_end) && ((*compare)(p, q) < 0))
+        {
+            p += size_per_item;
+        }
+        if (flags & VEC2_SET_A)
+        {
+            ok = vec2_set_put(&out, &room, run, (size_t)(p - run));
+        }
+        if (!ok || (p == p_end))
+        {
+            break;
+        }
+
+        /* the run of b less than *p */
+        run = q;
+        while ((q != q_end) && ((*compare)(q, p) < 0))
+        {
+            q += size_per_item;
+        }
+        if (flags & VEC2_SET_B)
+        {
+            ok = vec2_set_put(&out, &room, run, (size_t)(q - run));
+        }
+        if (!ok || (q == q_end))
+        {
+            break;
+        }
+        if (run != q)
+        {
+            continue;   /* *p may be less than *q */
+        }
+
+        /* *p is equal to *q */
+        if (flags & VEC2_SET_BOTH)
+        {
+            ok = vec2_set_put(&out, &room, p, size_per_item);
+        }
+        p += size_per_item;
+        q += size_per_item;
+    }
 
-#ifndef vec2_status_bad
-    #define vec2_status_bad(pv)    assert(0)
-#endif
+    if (ok && (flags & VEC2_SET_A))
+    {
+        ok = vec2_set_put(&out, &room, p, (size_t)(p_end - p));
+    }
+    if (ok && (flags & VEC2_SET_B))
+    {
+        ok = vec2_set_put(&out, &room, q, (size_t)(q_end - q));
+    }
 
-/****************************************************************************/
-/* C/C++ switching */
+    dest->num_items = (size_t)(out - (char *)dest->items) / size_per_item;
+    vec2_mark_dirty(dest, 0, dest->num_items);
+    return ok;
+} /* vec2_set_op */
 
-#ifdef __cplusplus
-extern "C"
+VEC2_API vec2_bool
+vec2_merge(PVEC2 dest, const VEC2 *a, const VEC2 *b,
+           VEC2_ITEM_COMPARE_FN compare)
 {
-#endif
-
-/****************************************************************************/
-/* functions */
+    VEC2_STATUS_INIT(ret, false);
 
-bool vec2_valid(const VEC2 *pv)
-{
-    bool ret;
+    assert(vec2_valid(dest));
+    assert(vec2_valid(a));
+    assert(vec2_valid(b));
+    assert(compare != NULL);
+    assert(a->size_per_item == dest->size_per_item);
+    assert(b->size_per_item == dest->size_per_item);
+    assert((dest->items != a->items) && (dest->items != b->items));
 
-    if ((pv == NULL) || (pv->num_items > pv->capacity))
+    if (a->num_items + b->num_items <= dest->capacity)
     {
-        ret = false;
+        vec2_merge_items((char *)dest->items, (const char *)a->items,
+                         a->num_items, (const char *)b->items, b->num_items,
+                         dest->size_per_item, compare);
+        dest->num_items = a->num_items + b->num_items;
+        vec2_mark_dirty(dest, 0, dest->num_items);
+        VEC2_STATUS_SET(ret, true);
     }
-    else if ((pv->num_items != 0U) && (pv->items == NULL))
+    else
     {
-        ret = false;
+        /* status bad */
+        vec2_status_bad(dest);
     }
-    else if (pv->size_per_item == 0U)
+
+    assert(vec2_valid(dest));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_merge */
+
+VEC2_API vec2_bool
+vec2_set_union(PVEC2 dest, const VEC2 *a, const VEC2 *b,
+               VEC2_ITEM_COMPARE_FN compare)
+{
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(dest));
+    assert(vec2_valid(a));
+    assert(vec2_valid(b));
+    assert(compare != NULL);
+    assert(a->size_per_item == dest->size_per_item);
+    assert(b->size_per_item == dest->size_per_item);
+    assert((dest->items != a->items) && (dest->items != b->items));
+
+    if (vec2_set_op(dest, a, b, compare,
+                    VEC2_SET_A | VEC2_SET_B | VEC2_SET_BOTH))
     {
-        ret = false;
+        VEC2_STATUS_SET(ret, true);
     }
     else
     {
-        ret = true;
+        /* status bad */
+        vec2_status_bad(dest);
     }
 
-    return ret;
-} /* vec2_valid */
+    assert(vec2_valid(dest));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_set_union */
 
-#ifndef NDEBUG
-    void *vec2_item(PVEC2 pv, size_t index0)
-    {
-        char *p;
-        assert(vec2_valid(pv));
-        assert(index0 <= vec2_size(pv));
-        p = (char *)pv->items;
-        return (void *)(p + index0 * pv->size_per_item);
-    } /* vec2_item */
+VEC2_API vec2_bool
+vec2_set_intersection(PVEC2 dest, const VEC2 *a, const VEC2 *b,
+                      VEC2_ITEM_COMPARE_FN compare)
+{
+    VEC2_STATUS_INIT(ret, false);
 
-    const void *vec2_const_item(const VEC2 *pv, size_t index0)
+    assert(vec2_valid(dest));
+    assert(vec2_valid(a));
+    assert(vec2_valid(b));
+    assert(compare != NULL);
+    assert(a->size_per_item == dest->size_per_item);
+    assert(b->size_per_item == dest->size_per_item);
+    assert((dest->items != a->items) && (dest->items != b->items));
+
+    if (vec2_set_op(dest, a, b, compare, VEC2_SET_BOTH))
     {
-        const char *p;
-        assert(vec2_valid(pv));
-        assert(index0 <= vec2_size(pv));
-        p = (const char *)pv->items;
-        return (const void *)(p + index0 * pv->size_per_item);
-    } /* vec2_const_item */
-#endif  /* ndef NDEBUG */
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(dest);
+    }
 
-vec2_bool
-vec2_construct(PVEC2 pv, size_t size_per_item,
-               size_t capacity, void *items, size_t num_items)
+    assert(vec2_valid(dest));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_set_intersection */
+
+VEC2_API vec2_bool
+vec2_set_difference(PVEC2 dest, const VEC2 *a, const VEC2 *b,
+                    VEC2_ITEM_COMPARE_FN compare)
 {
-    VEC2_STATUS_INIT(ret, true);
-    assert(items != NULL);
+    VEC2_STATUS_INIT(ret, false);
 
-    /* NOTE: vec2 doesn't allocate memory. Just weakly refers. */
-    pv->items = items;
-    pv->size_per_item = size_per_item;
-    pv->num_items = num_items;
-    pv->capacity = capacity;
+    assert(vec2_valid(dest));
+    assert(vec2_valid(a));
+    assert(vec2_valid(b));
+    assert(compare != NULL);
+    assert(a->size_per_item == dest->size_per_item);
+    assert(b->size_per_item == dest->size_per_item);
+    assert((dest->items != a->items) && (dest->items != b->items));
 
-    assert(vec2_valid(pv));
+    if (vec2_set_op(dest, a, b, compare, VEC2_SET_A))
+    {
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(dest);
+    }
 
+    assert(vec2_valid(dest));
     VEC2_STATUS_RETURN(ret);
-} /* vec2_construct */
+} /* vec2_set_difference */
 
-void vec2_destroy(PVEC2 pv)
+VEC2_API vec2_bool
+vec2_inplace_merge(PVEC2 pv, size_t mid, VEC2_ITEM_COMPARE_FN compare,
+                   PVEC2 scratch)
 {
-    assert(vec2_valid(pv));
-    /* NOTE: vec2 doesn't free memory. */
-} /* vec2_destroy */
+    char *ptr, *out, *b, *b_end;
+    const char *a, *a_end, *run;
+    size_t first, size_per_item;
+    VEC2 head;
+    VEC2_STATUS_INIT(ret, false);
 
-void vec2_clear(PVEC2 pv)
-{
     assert(vec2_valid(pv));
-    vec2_destroy(pv);
-    pv->num_items = 0;
-} /* vec2_clear */
+    assert(vec2_valid(scratch));
+    assert(compare != NULL);
+    assert(mid <= pv->num_items);
+    assert(pv->items != scratch->items);
 
-void *vec2_get_at(PVEC2 pv, size_t index0)
-{
-    char *ptr;
-    void *p = NULL;
-    assert(vec2_valid(pv));
-    assert(index0 <= pv->num_items);
-    if (index0 <= pv->num_items)
+    ptr = (char *)pv->items;
+    size_per_item = pv->size_per_item;
+
+    /* the items of [0, mid) not greater than the first of [mid, size)
+       stay there */
+    first = mid;
+    if ((mid > 0U) && (mid < pv->num_items))
     {
-        ptr = (char *)pv->items;
-        p = &ptr[index0 * pv->size_per_item];
+        head.items = ptr;
+        head.num_items = head.capacity = mid;
+        head.size_per_item = size_per_item;
+        first = vec2_bound(&head, &ptr[mid * size_per_item], compare, 1);
     }
-    return p;
-} /* vec2_get_at */
 
-void vec2_set_at(PVEC2 pv, size_t index0, const void *pitem)
-{
-    void *p;
-    assert(vec2_valid(pv));
-    p = vec2_get_at(pv, index0);
-    if (p != NULL)
+    if (first == mid)
     {
-        memcpy(p, pitem, pv->size_per_item);
+        /* already in order */
+        VEC2_STATUS_SET(ret, true);
     }
-    assert(vec2_valid(pv));
-} /* vec2_set_at */
-
-#ifndef MISRA_C
-    /* NOTE: vec2_bsearch() and vec2_sort() aren't available in MISRA-C. */
-
-    void *
-    vec2_bsearch(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare)
+    else if (scratch->capacity * scratch->size_per_item <
+             (mid - first) * size_per_item)
     {
-        assert(vec2_valid(pv));
-        assert(pitem != NULL);
-        assert(compare != NULL);
-        return bsearch(pitem, pv->items, pv->num_items,
-                       pv->size_per_item, compare);
-    } /* vec2_bsearch */
-
-    void vec2_sort(PVEC2 pv, VEC2_ITEM_COMPARE_FN compare)
+        /* status bad */
+        vec2_status_bad(pv);
+    }
+    else
     {
-        assert(vec2_valid(pv));
-        assert(compare != NULL);
-        qsort(pv->items, pv->num_items, pv->size_per_item, compare);
-    } /* vec2_sort */
-#endif  /* ndef MISRA_C */
+        /* move [first, mid) to scratch and merge it back from the front.
+           the output never passes the reading position of [mid, size). */
+        memcpy(scratch->items, &ptr[first * size_per_item],
+               (mid - first) * size_per_item);
+        a = (const char *)scratch->items;
+        a_end = a + (mid - first) * size_per_item;
+        b = &ptr[mid * size_per_item];
+        b_end = &ptr[pv->num_items * size_per_item];
+        out = &ptr[first * size_per_item];
+        while ((a != a_end) && (b != b_end))
+        {
+            run = b;
+            while ((b != b_end) && ((*compare)(b, a) < 0))
+            {
+                b += size_per_item;
+            }
+            memmove(out, run, (size_t)(b - run));
+            out += b - run;
+            if (b == b_end)
+            {
+                break;
+            }
+
+            run = a;
+            while ((a != a_end) && ((*compare)(a, b) <= 0))
+            {
+                a += size_per_item;
+            }
+            memcpy(out, run, (size_t)(a - run));
+            out += a - run;
+        }
+        memcpy(out, a, (size_t)(a_end - a));
+        vec2_mark_dirty(pv, first, pv->num_items - first);
+        VEC2_STATUS_SET(ret, true);
+    }
 
-vec2_bool vec2_reserve(PVEC2 pv, size_t capacity)
+    assert(vec2_valid(pv));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_inplace_merge */
+
+VEC2_API vec2_bool vec2_reserve(PVEC2 pv, size_t capacity)
 {
     VEC2_STATUS_INIT(ret, true);
 
@@ -166,13 +1662,13 @@ vec2_bool vec2_reserve(PVEC2 pv, size_t capacity)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_reserve */
 
-void vec2_shrink_to_fit(PVEC2 pv)
+VEC2_API void vec2_shrink_to_fit(PVEC2 pv)
 {
     /* does nothing */
     assert(vec2_valid(pv));
 } /* vec2_shrink_to_fit */
 
-vec2_bool vec2_erase(PVEC2 pv, size_t index0)
+VEC2_API vec2_bool vec2_erase(PVEC2 pv, size_t index0)
 {
     char *ptr;
     VEC2_STATUS_INIT(ret, false);
@@ -189,6 +1685,7 @@ vec2_bool vec2_erase(PVEC2 pv, size_t index0)
             &ptr[(index0 + 1) * pv->size_per_item],
             ((pv->num_items - index0) - 1U) * pv->size_per_item);
         pv->num_items -= 1U;
+        vec2_mark_dirty(pv, index0, pv->num_items - index0);
         VEC2_STATUS_SET(ret, true);
     }
 
@@ -196,7 +1693,36 @@ vec2_bool vec2_erase(PVEC2 pv, size_t index0)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_erase */
 
-vec2_bool vec2_push_back(PVEC2 pv, const void *pitem)
+VEC2_API vec2_bool vec2_erase_unordered(PVEC2 pv, size_t index0)
+{
+    char *ptr;
+    size_t last;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(pv));
+    assert(pv->num_items > 0U);
+    assert(index0 < pv->num_items);
+
+    if (index0 < pv->num_items)
+    {
+        ptr = (char *)pv->items;
+        last = pv->num_items - 1U;
+        if (index0 != last)
+        {
+            vec2_copy_item(&ptr[index0 * pv->size_per_item],
+                           &ptr[last * pv->size_per_item],
+                           pv->size_per_item);
+            vec2_mark_dirty(pv, index0, 1);
+        }
+        pv->num_items = last;
+        VEC2_STATUS_SET(ret, true);
+    }
+
+    assert(vec2_valid(pv));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_erase_unordered */
+
+VEC2_API vec2_bool vec2_push_back(PVEC2 pv, const void *pitem)
 {
     char *ptr;
     VEC2_STATUS_INIT(ret, false);
@@ -215,6 +1741,7 @@ vec2_bool vec2_push_back(PVEC2 pv, const void *pitem)
             &ptr[pv->num_items * pv->size_per_item],
             pitem,
             pv->size_per_item);
+        vec2_mark_dirty(pv, pv->num_items, 1);
         pv->num_items += 1U;
         VEC2_STATUS_SET(ret, true);
     }
@@ -223,7 +1750,65 @@ vec2_bool vec2_push_back(PVEC2 pv, const void *pitem)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_push_back */
 
-vec2_bool vec2_pop_back(PVEC2 pv)
+VEC2_API size_t vec2_append(PVEC2 pv, const void *items, size_t count)
+{
+    char *ptr;
+
+    assert(vec2_valid(pv));
+    assert((items != NULL) || (count == 0U));
+
+    if (count > pv->capacity - pv->num_items)
+    {
+        count = pv->capacity - pv->num_items;
+    }
+    if (count > 0U)
+    {
+        ptr = (char *)pv->items;
+        memcpy(&ptr[pv->num_items * pv->size_per_item], items,
+               count * pv->size_per_item);
+        vec2_mark_dirty(pv, pv->num_items, count);
+        pv->num_items += count;
+    }
+
+    assert(vec2_valid(pv));
+    return count;
+} /* vec2_append */
+
+VEC2_API size_t vec2_push_back_n(PVEC2 pv, size_t count, const void *pitem)
+{
+    char *ptr;
+
+    assert(vec2_valid(pv));
+
+    if (count > pv->capacity - pv->num_items)
+    {
+        count = pv->capacity - pv->num_items;
+    }
+    if (count > 0U)
+    {
+        ptr = (char *)pv->items;
+        ptr = &ptr[pv->num_items * pv->size_per_item];
+        if (pitem != NULL)
+        {
+            vec2_fill_items(ptr, pitem, pv->size_per_item, count);
+        }
+        else
+        {
+#ifdef VEC2_NO_ZERO_INIT
+            ;
+#else
+            memset(ptr, 0, count * pv->size_per_item);
+#endif
+        }
+        vec2_mark_dirty(pv, pv->num_items, count);
+        pv->num_items += count;
+    }
+
+    assert(vec2_valid(pv));
+    return count;
+} /* vec2_push_back_n */
+
+VEC2_API vec2_bool vec2_pop_back(PVEC2 pv)
 {
     VEC2_STATUS_INIT(ret, false);
     assert(vec2_valid(pv));
@@ -236,7 +1821,7 @@ vec2_bool vec2_pop_back(PVEC2 pv)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_pop_back */
 
-void vec2_swap(PVEC2 pv1, PVEC2 pv2)
+VEC2_API void vec2_swap(PVEC2 pv1, PVEC2 pv2)
 {
     VEC2 v;
 
@@ -254,7 +1839,7 @@ void vec2_swap(PVEC2 pv1, PVEC2 pv2)
     assert(vec2_valid(pv2));
 } /* vec2_swap */
 
-vec2_bool vec2_copy(PVEC2 dest, const VEC2 *src)
+VEC2_API vec2_bool vec2_copy(PVEC2 dest, const VEC2 *src)
 {
     VEC2_STATUS_INIT(ret, false);
 
@@ -276,6 +1861,7 @@ vec2_bool vec2_copy(PVEC2 dest, const VEC2 *src)
             memcpy(dest->items, src->items,
                    src->num_items * dest->size_per_item);
             dest->num_items = src->num_items;
+            vec2_mark_dirty(dest, 0, dest->num_items);
         }
     }
 
@@ -283,10 +1869,10 @@ vec2_bool vec2_copy(PVEC2 dest, const VEC2 *src)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_copy */
 
-vec2_bool vec2_resize(PVEC2 pv, size_t count, const void *pitem)
+VEC2_API vec2_bool vec2_resize(PVEC2 pv, size_t count, const void *pitem)
 {
     char *p;
-    size_t i, old_num_items = pv->num_items;
+    size_t old_num_items = pv->num_items;
     VEC2_STATUS_INIT(ret, false);
 
     assert(vec2_valid(pv));
@@ -302,11 +1888,8 @@ vec2_bool vec2_resize(PVEC2 pv, size_t count, const void *pitem)
             p = (char *)pv->items;
             if (pitem != NULL)
             {
-                for (i = old_num_items; i < count; ++i)
-                {
-                    memcpy(&p[i * pv->size_per_item], pitem,
-                           pv->size_per_item);
-                }
+                vec2_fill_items(&p[old_num_items * pv->size_per_item], pitem,
+                                pv->size_per_item, count - old_num_items);
             }
             else
             {
@@ -317,6 +1900,7 @@ vec2_bool vec2_resize(PVEC2 pv, size_t count, const void *pitem)
                        (count - old_num_items) * pv->size_per_item);
 #endif
             }
+            vec2_mark_dirty(pv, old_num_items, count - old_num_items);
         }
         pv->num_items = count;
         VEC2_STATUS_SET(ret, true);
@@ -326,11 +1910,9 @@ vec2_bool vec2_resize(PVEC2 pv, size_t count, const void *pitem)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_resize */
 
-vec2_bool vec2_assign(PVEC2 pv, size_t count, const void *pitem,
-                      size_t size_per_item)
+VEC2_API vec2_bool
+vec2_assign(PVEC2 pv, size_t count, const void *pitem, size_t size_per_item)
 {
-    size_t i;
-    char *ptr;
     VEC2_STATUS_INIT(ret, false);
 
     assert(vec2_valid(pv));
@@ -343,11 +1925,7 @@ vec2_bool vec2_assign(PVEC2 pv, size_t count, const void *pitem,
     {
         if (pitem != NULL)
         {
-            ptr = (char *)pv->items;
-            for (i = 0; i < count; ++i)
-            {
-                memcpy(&ptr[i * size_per_item], pitem, size_per_item);
-            }
+            vec2_fill_items(pv->items, pitem, size_per_item, count);
         }
         else
         {
@@ -358,6 +1936,7 @@ vec2_bool vec2_assign(PVEC2 pv, size_t count, const void *pitem,
 #endif
         }
         pv->num_items = count;
+        vec2_mark_dirty(pv, 0, count);
         VEC2_STATUS_SET(ret, true);
     }
 
@@ -365,7 +1944,7 @@ vec2_bool vec2_assign(PVEC2 pv, size_t count, const void *pitem,
     VEC2_STATUS_RETURN(ret);
 } /* vec2_assign */
 
-void vec2_foreach(PVEC2 pv, VEC2_FOREACH_FN fn)
+VEC2_API void vec2_foreach(PVEC2 pv, VEC2_FOREACH_FN fn)
 {
     char *ptr;
     size_t i, count, size_per_item;
@@ -390,7 +1969,7 @@ void vec2_foreach(PVEC2 pv, VEC2_FOREACH_FN fn)
     assert(vec2_valid(pv));
 } /* vec2_foreach */
 
-void vec2_foreach_reverse(PVEC2 pv, VEC2_FOREACH_FN fn)
+VEC2_API void vec2_foreach_reverse(PVEC2 pv, VEC2_FOREACH_FN fn)
 {
     char *ptr;
     size_t i, count, size_per_item;
@@ -415,7 +1994,8 @@ void vec2_foreach_reverse(PVEC2 pv, VEC2_FOREACH_FN fn)
     assert(vec2_valid(pv));
 } /* vec2_foreach_reverse */
 
-void vec2_foreach_range(PVEC2 pv, VEC2_FOREACH_FN fn, size_t index0, size_t count)
+VEC2_API void
+vec2_foreach_range(PVEC2 pv, VEC2_FOREACH_FN fn, size_t index0, size_t count)
 {
     char *ptr;
     size_t i, size_per_item;
@@ -441,9 +2021,47 @@ void vec2_foreach_range(PVEC2 pv, VEC2_FOREACH_FN fn, size_t index0, size_t coun
     }
 
     assert(vec2_valid(pv));
-} /* vec2_foreach_range */
+} /* vec2_foreach_range */
+
+VEC2_API void
+vec2_foreach_batch(PVEC2 pv, VEC2_BATCH_FN fn, size_t batch_hint)
+{
+    char *ptr;
+    size_t i, count, span, size_per_item;
+
+    assert(vec2_valid(pv));
+    assert(fn != NULL);
+
+    size_per_item = pv->size_per_item;
+    if (batch_hint == 0U)
+    {
+        batch_hint = VEC2_BATCH_BYTES / size_per_item;
+        if (batch_hint == 0U)
+        {
+            batch_hint = 1;
+        }
+    }
+
+    count = pv->num_items;
+    ptr = (char *)pv->items;
+    for (i = 0; i < count; i += span)
+    {
+        span = count - i;
+        if (span > batch_hint)
+        {
+            span = batch_hint;
+        }
+        if ((*fn)(i, &ptr[i * size_per_item], span) == false)
+        {
+            break;
+        }
+    }
+
+    assert(vec2_valid(pv));
+} /* vec2_foreach_batch */
 
-void *vec2_find(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare)
+VEC2_API void *
+vec2_find(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare)
 {
     char *ptr;
     size_t i, count;
@@ -469,7 +2087,77 @@ void *vec2_find(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare)
     return ret;
 } /* vec2_find */
 
-vec2_bool vec2_reserve_2(PVEC2 pv, size_t capacity, size_t size_per_item)
+VEC2_API void *vec2_find_bytes(PVEC2 pv, const void *pitem)
+{
+    size_t i;
+    char *ptr;
+
+    assert(vec2_valid(pv));
+    assert(pitem != NULL);
+
+    i = vec2_scan_key((const char *)pv->items, pv->num_items,
+                      pv->size_per_item, 0, pitem, 0, pv->size_per_item);
+    if (i == VEC2_NPOS)
+    {
+        return NULL;
+    }
+    ptr = (char *)pv->items;
+    return &ptr[i * pv->size_per_item];
+} /* vec2_find_bytes */
+
+VEC2_API size_t
+vec2_find_key(const VEC2 *pv, size_t index0, const void *key,
+              size_t key_offset, size_t key_size)
+{
+    assert(vec2_valid(pv));
+    assert(key != NULL);
+    assert(key_size > 0U);
+    assert(key_offset + key_size <= pv->size_per_item);
+
+    if (index0 >= pv->num_items)
+    {
+        return VEC2_NPOS;
+    }
+    return vec2_scan_key((const char *)pv->items, pv->num_items,
+                         pv->size_per_item, index0,
+                         key, key_offset, key_size);
+} /* vec2_find_key */
+
+VEC2_API size_t
+vec2_count_key(const VEC2 *pv, const void *key,
+               size_t key_offset, size_t key_size)
+{
+    assert(vec2_valid(pv));
+    assert(key != NULL);
+    assert(key_size > 0U);
+    assert(key_offset + key_size <= pv->size_per_item);
+
+    return vec2_scan_keys((const char *)pv->items, pv->num_items,
+                          pv->size_per_item, 0, key, key_offset, key_size,
+                          NULL, VEC2_NPOS);
+} /* vec2_count_key */
+
+VEC2_API size_t
+vec2_find_all_key(const VEC2 *pv, const void *key, size_t key_offset,
+                  size_t key_size, size_t *indexes, size_t max_indexes)
+{
+    assert(vec2_valid(pv));
+    assert(key != NULL);
+    assert(key_size > 0U);
+    assert(key_offset + key_size <= pv->size_per_item);
+    assert((indexes != NULL) || (max_indexes == 0U));
+
+    if (max_indexes == 0U)
+    {
+        return 0;
+    }
+    return vec2_scan_keys((const char *)pv->items, pv->num_items,
+                          pv->size_per_item, 0, key, key_offset, key_size,
+                          indexes, max_indexes);
+} /* vec2_find_all_key */
+
+VEC2_API vec2_bool
+vec2_reserve_2(PVEC2 pv, size_t capacity, size_t size_per_item)
 {
     size_t new_size;
     VEC2_STATUS_INIT(ret, true);
@@ -495,10 +2183,10 @@ vec2_bool vec2_reserve_2(PVEC2 pv, size_t capacity, size_t size_per_item)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_reserve_2 */
 
-vec2_bool vec2_insert(PVEC2 pv, size_t index0, size_t count, const void *pitem)
+VEC2_API vec2_bool
+vec2_insert(PVEC2 pv, size_t index0, size_t count, const void *pitem)
 {
     char *ptr;
-    size_t i;
     VEC2_STATUS_INIT(ret, false);
 
     assert(vec2_valid(pv));
@@ -516,11 +2204,10 @@ vec2_bool vec2_insert(PVEC2 pv, size_t index0, size_t count, const void *pitem)
             &ptr[(index0 + count) * pv->size_per_item],
             &ptr[index0 * pv->size_per_item],
             (pv->num_items - index0) * pv->size_per_item);
-        for (i = index0; i < index0 + count; ++i)
-        {
-            memcpy(&ptr[i * pv->size_per_item], pitem, pv->size_per_item);
-        }
+        vec2_fill_items(&ptr[index0 * pv->size_per_item], pitem,
+                        pv->size_per_item, count);
         pv->num_items += count;
+        vec2_mark_dirty(pv, index0, pv->num_items - index0);
         VEC2_STATUS_SET(ret, true);
     }
 
@@ -528,7 +2215,8 @@ vec2_bool vec2_insert(PVEC2 pv, size_t index0, size_t count, const void *pitem)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_insert */
 
-vec2_bool vec2_insert_sub(PVEC2 pv, size_t index0, const VEC2 *psubvec)
+VEC2_API vec2_bool
+vec2_insert_sub(PVEC2 pv, size_t index0, const VEC2 *psubvec)
 {
     char *ptr;
     size_t count = vec2_size(psubvec);
@@ -553,6 +2241,7 @@ vec2_bool vec2_insert_sub(PVEC2 pv, size_t index0, const VEC2 *psubvec)
         memcpy(&ptr[index0 * pv->size_per_item], psubvec->items,
                count * pv->size_per_item);
         pv->num_items += count;
+        vec2_mark_dirty(pv, index0, pv->num_items - index0);
         VEC2_STATUS_SET(ret, true);
     }
 
@@ -560,7 +2249,7 @@ vec2_bool vec2_insert_sub(PVEC2 pv, size_t index0, const VEC2 *psubvec)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_insert_sub */
 
-vec2_bool vec2_erase_range(PVEC2 pv, size_t index0, size_t count)
+VEC2_API vec2_bool vec2_erase_range(PVEC2 pv, size_t index0, size_t count)
 {
     char *ptr;
     VEC2_STATUS_INIT(ret, false);
@@ -580,6 +2269,7 @@ vec2_bool vec2_erase_range(PVEC2 pv, size_t index0, size_t count)
                 &ptr[(index0 + count) * pv->size_per_item],
                 ((pv->num_items - index0) - count) * pv->size_per_item);
             pv->num_items -= count;
+            vec2_mark_dirty(pv, index0, pv->num_items - index0);
             VEC2_STATUS_SET(ret, true);
         }
     }
@@ -588,6 +2278,262 @@ vec2_bool vec2_erase_range(PVEC2 pv, size_t index0, size_t count)
     VEC2_STATUS_RETURN(ret);
 } /* vec2_erase_range */
 
+VEC2_API vec2_bool
+vec2_erase_range_unordered(PVEC2 pv, size_t index0, size_t count)
+{
+    char *ptr;
+    size_t moved;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(pv));
+    assert(pv->num_items >= count);
+    assert(index0 < pv->num_items);
+    assert((index0 + count) <= pv->num_items);
+
+    if ((count != 0U) && ((index0 + count) <= pv->num_items))
+    {
+        /* the tail after the hole, or the last count items of it */
+        moved = pv->num_items - (index0 + count);
+        if (moved > count)
+        {
+            moved = count;
+        }
+        ptr = (char *)pv->items;
+        memcpy(&ptr[index0 * pv->size_per_item],
+               &ptr[(pv->num_items - moved) * pv->size_per_item],
+               moved * pv->size_per_item);
+        vec2_mark_dirty(pv, index0, moved);
+        pv->num_items -= count;
+        VEC2_STATUS_SET(ret, true);
+    }
+
+    assert(vec2_valid(pv));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_erase_range_unordered */
+
+/* the bytes of a run that vec2_erase_if() moves by items */
+#ifndef VEC2_ERASE_SHORT_RUN
+    #define VEC2_ERASE_SHORT_RUN    64
+#endif
+
+VEC2_API size_t vec2_erase_if(PVEC2 pv, VEC2_PREDICATE_FN pred)
+{
+    char *ptr;
+    size_t i, n, run, dest, size_per_item;
+    bool kept;
+
+    assert(vec2_valid(pv));
+    assert(pred != NULL);
+
+    ptr = (char *)pv->items;
+    n = pv->num_items;
+    size_per_item = pv->size_per_item;
+    dest = 0;
+    i = 0;
+    kept = false;   /* whether the item at i is a known survivor */
+    while (i < n)
+    {
+        /* move the run of the survivors at once */
+        /* NOTE: pred is called once per item. The loops stop at the item
+         *       of the other kind, and the next loop starts after it. */
+        run = i;
+        if (kept)
+        {
+            ++i;
+        }
+        while ((i < n) && !(*pred)(i, &ptr[i * size_per_item]))
+        {
+            ++i;
+        }
+        if (run == dest)
+        {
+            dest = i;
+        }
+        else if ((i - run) * size_per_item <= VEC2_ERASE_SHORT_RUN)
+        {
+            vec2_mark_dirty(pv, dest, i - run);
+            /* a short run by items. the items don't overlap. */
+            for (; run < i; ++run, ++dest)
+            {
+                vec2_copy_item(&ptr[dest * size_per_item],
+                               &ptr[run * size_per_item], size_per_item);
+            }
+        }
+        else
+        {
+            vec2_mark_dirty(pv, dest, i - run);
+            memmove(&ptr[dest * size_per_item], &ptr[run * size_per_item],
+                    (i - run) * size_per_item);
+            dest += i - run;
+        }
+
+        /* skip the run of the erased */
+        if (i < n)
+        {
+            ++i;
+            while ((i < n) && (*pred)(i, &ptr[i * size_per_item]))
+            {
+                ++i;
+            }
+        }
+        kept = (i < n);
+    }
+    pv->num_items = dest;
+
+    assert(vec2_valid(pv));
+    return n - dest;
+} /* vec2_erase_if */
+
+VEC2_API vec2_bool
+vec2_erase_indices(PVEC2 pv, const size_t *indexes, size_t count)
+{
+    char *ptr;
+    size_t i, j, n, run, dest, size_per_item;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(pv));
+    assert((indexes != NULL) || (count == 0U));
+#ifndef NDEBUG
+    for (j = 1; j < count; ++j)
+    {
+        assert(indexes[j - 1] <= indexes[j]);
+    }
+#endif
+    assert((count == 0U) || (indexes[count - 1] < pv->num_items));
+
+    if ((count == 0U) || (indexes[count - 1] < pv->num_items))
+    {
+        ptr = (char *)pv->items;
+        n = pv->num_items;
+        size_per_item = pv->size_per_item;
+        dest = i = (count > 0U) ? indexes[0] : n;
+        for (j = 0; j < count; ++j)
+        {
+            if (indexes[j] < i)
+            {
+                continue;   /* duplicate */
+            }
+            /* move the survivors before indexes[j] at once */
+            run = indexes[j] - i;
+            memmove(&ptr[dest * size_per_item], &ptr[i * size_per_item],
+                    run * size_per_item);
+            dest += run;
+            i = indexes[j] + 1;
+        }
+        memmove(&ptr[dest * size_per_item], &ptr[i * size_per_item],
+                (n - i) * size_per_item);
+        pv->num_items = dest + (n - i);
+        if (count > 0U)
+        {
+            vec2_mark_dirty(pv, indexes[0], pv->num_items - indexes[0]);
+        }
+        VEC2_STATUS_SET(ret, true);
+    }
+
+    assert(vec2_valid(pv));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_erase_indices */
+
+/****************************************************************************/
+/* dirty tracking */
+
+#ifdef VEC2_DIRTY_TRACKING
+    VEC2_API void
+    vec2_track_dirty(PVEC2 pv, unsigned char *bitmap, size_t chunk_shift)
+    {
+        assert(vec2_valid(pv));
+        assert(chunk_shift < sizeof(size_t) * 8U);
+
+        pv->dirty = bitmap;
+        pv->dirty_shift = chunk_shift;
+        if (bitmap != NULL)
+        {
+            memset(bitmap, 0, VEC2_DIRTY_BITMAP_SIZE(pv->capacity,
+                                                     pv->size_per_item,
+                                                     chunk_shift));
+        }
+    } /* vec2_track_dirty */
+
+    VEC2_API void vec2_mark_dirty(PVEC2 pv, size_t index0, size_t count)
+    {
+        unsigned char *dirty = pv->dirty;
+        size_t first, last;
+
+        assert(vec2_valid(pv));
+        assert(index0 + count <= pv->capacity);
+
+        if ((dirty != NULL) && (count > 0U))
+        {
+            /* the chunks of the first and the last bytes */
+            first = (index0 * pv->size_per_item) >> pv->dirty_shift;
+            last = ((index0 + count) * pv->size_per_item - 1U) >>
+                   pv->dirty_shift;
+            if ((first >> 3) == (last >> 3))
+            {
+                dirty[first >> 3] |= (unsigned char)
+                    ((0xFFU << (first & 7U)) & (0xFFU >> (7U - (last & 7U))));
+            }
+            else
+            {
+                dirty[first >> 3] |= (unsigned char)(0xFFU << (first & 7U));
+                memset(&dirty[(first >> 3) + 1U], 0xFF,
+                       (last >> 3) - (first >> 3) - 1U);
+                dirty[last >> 3] |= (unsigned char)
+                    (0xFFU >> (7U - (last & 7U)));
+            }
+        }
+    } /* vec2_mark_dirty */
+
+    VEC2_API size_t
+    vec2_dirty_ranges(PVEC2 pv, VEC2_RANGE *ranges, size_t max_ranges)
+    {
+        unsigned char *dirty = pv->dirty;
+        size_t i, start, end, num_chunks, block_size, shift, n = 0;
+
+        assert(vec2_valid(pv));
+        assert((ranges != NULL) || (max_ranges == 0U));
+
+        if (dirty != NULL)
+        {
+            shift = pv->dirty_shift;
+            block_size = pv->capacity * pv->size_per_item;
+            num_chunks = (block_size + ((size_t)1 << shift) - 1U) >> shift;
+            i = 0;
+            while ((i < num_chunks) && (n < max_ranges))
+            {
+                if (dirty[i >> 3] == 0)
+                {
+                    /* skip eight clean chunks at once */
+                    i = (i | 7U) + 1U;
+                }
+                else if ((dirty[i >> 3] & (1U << (i & 7U))) == 0)
+                {
+                    ++i;
+                }
+                else
+                {
+                    /* take the run of the dirty chunks */
+                    start = i;
+                    do
+                    {
+                        dirty[i >> 3] &= (unsigned char)~(1U << (i & 7U));
+                        ++i;
+                    } while ((i < num_chunks) &&
+                             ((dirty[i >> 3] & (1U << (i & 7U))) != 0));
+
+                    end = i << shift;
+                    ranges[n].offset = start << shift;
+                    ranges[n].size = ((end < block_size) ? end : block_size) -
+                                     ranges[n].offset;
+                    ++n;
+                }
+            }
+        }
+
+        return n;
+    } /* vec2_dirty_ranges */
+#endif  /* def VEC2_DIRTY_TRACKING */
+
 /****************************************************************************/
 /* C/C++ switching */
 
@@ -602,6 +2548,61 @@ vec2_bool vec2_erase_range(PVEC2 pv, size_t index0, size_t count)
 
 #ifdef VEC2_TEST
     #include <stdio.h>
+    #include "vec2_typed.h"
+    #include "vec2_sort.h"
+
+    VEC2_DECLARE(LONGVEC, long)
+
+    #define LONG_LESS(a,b)  (*(a) < *(b))
+    VEC2_DECLARE_SORT(long_sort, long, LONG_LESS)
+    VEC2_DECLARE_SEARCH(long_search, long, LONG_LESS)
+
+    /* tag is the input order, to check the stability */
+    typedef struct PAIR
+    {
+        int key;
+        int tag;
+    } PAIR;
+
+    #define PAIR_LESS(a,b)  ((a)->key < (b)->key)
+    VEC2_DECLARE_SORT(pair_sort, PAIR, PAIR_LESS)
+
+    int pair_compare(const void *x, const void *y)
+    {
+        const PAIR *a = (const PAIR *)x;
+        const PAIR *b = (const PAIR *)y;
+        return (a->key > b->key) - (a->key < b->key);
+    }
+
+    /* fills the pairs of few distinct keys in a scrambled order */
+    void pair_fill(PAIR *pairs, size_t count)
+    {
+        size_t i;
+        for (i = 0; i < count; ++i)
+        {
+            pairs[i].key = (int)((i * 37U) % 7U);
+            pairs[i].tag = (int)i;
+        }
+    }
+
+    /* the keys are in order and the equal keys keep the input order */
+    bool pair_stable(const PAIR *pairs, size_t count)
+    {
+        size_t i;
+        for (i = 1; i < count; ++i)
+        {
+            if (pairs[i - 1].key > pairs[i].key)
+            {
+                return false;
+            }
+            if ((pairs[i - 1].key == pairs[i].key) &&
+                (pairs[i - 1].tag > pairs[i].tag))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
 
     bool print_foreach(size_t index0, void *ptr)
     {
@@ -609,6 +2610,51 @@ vec2_bool vec2_erase_range(PVEC2 pv, size_t index0, size_t count)
         return true;
     }
 
+    static long s_batch_sum = 0;
+    static size_t s_batch_spans = 0;
+
+    bool sum_batch(size_t index0, void *pitems, size_t count)
+    {
+        const long *p = (const long *)pitems;
+        size_t i;
+        (void)index0;
+        for (i = 0; i < count; ++i)
+        {
+            s_batch_sum += p[i];
+        }
+        ++s_batch_spans;
+        return s_batch_sum < 100;
+    }
+
+    static size_t s_pred_calls = 0;
+    static size_t s_erase_first = 0;
+
+    bool is_odd(size_t index0, const void *ptr)
+    {
+        (void)index0;
+        ++s_pred_calls;
+        return (*(const long *)ptr % 2) != 0;
+    }
+
+    /* erases the first s_erase_first items it sees */
+    bool erase_first(size_t index0, const void *ptr)
+    {
+        (void)index0;
+        (void)ptr;
+        ++s_pred_calls;
+        if (s_erase_first > 0U)
+        {
+            --s_erase_first;
+            return true;
+        }
+        return false;
+    }
+
+    bool long_erase_first(size_t index0, const long *ptr)
+    {
+        return erase_first(index0, ptr);
+    }
+
     int long_compare(const void *x, const void *y)
     {
         const long *a = (const long *)x;
@@ -731,8 +2777,428 @@ vec2_bool vec2_erase_range(PVEC2 pv, size_t index0, size_t count)
         vec2_destroy(&vec1);
         vec2_destroy(&vec2);
 
+        /* bulk append */
+        {
+            static const long more[3] = { 5, 6, 7 };
+            static long items3[4];
+            size_t count;
+            VEC2 vec3;
+            vec2_construct(&vec3, siz, 4, items3, 0);
+            count = vec2_append(&vec3, more, 3);
+            assert(count == 3);
+            n = 8;
+            count = vec2_push_back_n(&vec3, 2, &n);
+            assert(count == 1);
+            count = vec2_append(&vec3, more, 3);
+            assert(count == 0);
+            assert(vec2_size(&vec3) == 4);
+            assert(items3[0] == 5 && items3[2] == 7 && items3[3] == 8);
+        }
+
+        /* byte-equality search */
+        {
+            size_t indexes[4];
+            size_t count;
+            n = 3;
+            assert(vec2_find_bytes(&vec2, &n) == vec2_item(&vec2, 1));
+            assert(vec2_find_key(&vec2, 0, &n, 0, siz) == 1);
+            assert(vec2_find_key(&vec2, 2, &n, 0, siz) == VEC2_NPOS);
+            count = vec2_find_all_key(&vec2, &n, 0, siz, indexes, 4);
+            assert(count == 1 && indexes[0] == 1);
+            assert(vec2_count_key(&vec2, &n, 0, siz) == 1);
+        }
+
+        /* dense matches in one pass */
+        {
+            static unsigned char bytes[4 * 300];
+            static size_t indexes[300];
+            static const unsigned char key[2] = { 0x12, 0x34 };
+            size_t i, count, expected;
+            bool ok;
+            VEC2 vec3;
+            for (i = 0; i < sizeof(bytes); ++i)
+            {
+                bytes[i] = (unsigned char)(i * 7U);
+            }
+            expected = 0;
+            for (i = 0; i < 300; ++i)
+            {
+                if ((i % 3U != 0U) || (i > 250U))
+                {
+                    memcpy(&bytes[i * 4 + 1], key, 2);
+                    ++expected;
+                }
+            }
+            vec2_construct(&vec3, 4, 300, bytes, 300);
+            assert(vec2_count_key(&vec3, key, 1, 2) == expected);
+            count = vec2_find_all_key(&vec3, key, 1, 2, indexes, 300);
+            ok = (count == expected);
+            for (i = 1; i < count; ++i)
+            {
+                ok = ok && (indexes[i - 1] < indexes[i]);
+                ok = ok && (memcmp(&bytes[indexes[i] * 4 + 1], key, 2) == 0);
+            }
+            assert(ok);
+            count = vec2_find_all_key(&vec3, key, 1, 2, indexes, 5);
+            assert(count == 5 && indexes[0] == 1 && indexes[4] == 7);
+            assert(vec2_find_all_key(&vec3, key, 1, 2, indexes, 0) == 0);
+        }
+
+        /* radix sort */
+        {
+            static const long unsorted[5] = { 3, -1, 2, -5, 0 };
+            static long items3[5], scratch[5];
+            VEC2 vec3, vec4;
+            vec2_construct(&vec3, siz, 5, items3, 0);
+            vec2_construct(&vec4, siz, 5, scratch, 0);
+            vec2_append(&vec3, unsorted, 5);
+            vec2_sort_by_key(&vec3, 0, siz, VEC2_KEY_SIGNED, &vec4);
+            assert(items3[0] == -5 && items3[1] == -1 && items3[2] == 0);
+            assert(items3[3] == 2 && items3[4] == 3);
+        }
+
+        /* batch iteration */
+        {
+            static long items3[10];
+            VEC2 vec3;
+            vec2_construct(&vec3, siz, 10, items3, 0);
+            for (n = 1; n <= 10; ++n)
+            {
+                vec2_push_back(&vec3, &n);
+            }
+            vec2_foreach_batch(&vec3, sum_batch, 3);
+            assert(s_batch_sum == 55 && s_batch_spans == 4);
+            s_batch_sum = 90;
+            s_batch_spans = 0;
+            vec2_foreach_batch(&vec3, sum_batch, 0);
+            assert(s_batch_sum == 145 && s_batch_spans == 1);
+            s_batch_sum = 90;
+            s_batch_spans = 0;
+            vec2_foreach_batch(&vec3, sum_batch, 2);
+            assert(s_batch_sum == 100 && s_batch_spans == 2);
+        }
+
+        /* bulk erase */
+        {
+            static const size_t indexes[4] = { 0, 2, 2, 5 };
+            static long items3[10];
+            size_t count;
+            VEC2 vec3;
+            vec2_construct(&vec3, siz, 10, items3, 0);
+            for (n = 0; n < 10; ++n)
+            {
+                vec2_push_back(&vec3, &n);
+            }
+            s_pred_calls = 0;
+            count = vec2_erase_if(&vec3, is_odd);
+            assert(count == 5 && vec2_size(&vec3) == 5);
+            assert(items3[0] == 0 && items3[1] == 2 && items3[4] == 8);
+            assert(s_pred_calls == 10);
+
+            /* a stateful predicate sees each item once */
+            s_pred_calls = 0;
+            s_erase_first = 2;
+            count = vec2_erase_if(&vec3, erase_first);
+            assert(count == 2 && vec2_size(&vec3) == 3);
+            assert(items3[0] == 4 && items3[2] == 8);
+            assert(s_pred_calls == 5);
+            vec2_clear(&vec3);
+            for (n = 0; n < 10; ++n)
+            {
+                vec2_push_back(&vec3, &n);
+            }
+            count = vec2_erase_if(&vec3, is_odd);
+            assert(count == 5);
+            vec2_push_back(&vec3, &n);
+            vec2_erase_indices(&vec3, indexes, 4);
+            assert(vec2_size(&vec3) == 3);
+            assert(items3[0] == 2 && items3[1] == 6 && items3[2] == 8);
+        }
+
+        /* unordered erase */
+        {
+            static long items3[10];
+            VEC2 vec3;
+            vec2_construct(&vec3, siz, 10, items3, 0);
+            for (n = 0; n < 10; ++n)
+            {
+                vec2_push_back(&vec3, &n);
+            }
+            vec2_erase_unordered(&vec3, 2);
+            assert(vec2_size(&vec3) == 9 && items3[2] == 9);
+            vec2_erase_range_unordered(&vec3, 1, 3);
+            assert(vec2_size(&vec3) == 6);
+            assert(items3[1] == 6 && items3[2] == 7 && items3[3] == 8);
+            vec2_erase_range_unordered(&vec3, 3, 2);
+            assert(vec2_size(&vec3) == 4 && items3[3] == 5);
+            vec2_erase_unordered(&vec3, 3);
+            assert(vec2_size(&vec3) == 3 && items3[2] == 7);
+        }
+
+        /* sorted vector */
+        {
+            static long items3[8];
+            size_t first, count;
+            VEC2 vec3;
+            vec2_construct(&vec3, siz, 8, items3, 0);
+            for (n = 5; n >= 0; --n)
+            {
+                vec2_insert_sorted(&vec3, &n, long_compare);
+            }
+            /* 0 1 2 3 4 5 */
+            n = 3;
+            vec2_insert_sorted(&vec3, &n, long_compare);
+            first = vec2_lower_bound(&vec3, &n, long_compare);
+            assert(first == 3);
+            first = vec2_upper_bound(&vec3, &n, long_compare);
+            assert(first == 5);
+            first = vec2_equal_range_key(&vec3, &n, 0, siz, VEC2_KEY_SIGNED,
+                                         &count);
+            assert(first == 3 && count == 2);
+            count = vec2_erase_key(&vec3, &n, long_compare);
+            assert(count == 2 && vec2_size(&vec3) == 5 && items3[3] == 4);
+            n = 9;
+            first = vec2_lower_bound_key(&vec3, &n, 0, siz, VEC2_KEY_SIGNED);
+            assert(first == 5);
+        }
+
+        /* float keys are searched in the order of vec2_sort_by_key() */
+        {
+            static double items3[5], items4[5], items5[7];
+            double zero = 0.0;
+            size_t i, first, count;
+            bool ok;
+            VEC2 vec3, vec4, vec5;
+            items3[0] = 1.0;
+            items3[1] = zero / zero;                /* NaN */
+            items3[2] = 0.0;
+            items3[3] = -1.0;
+            items3[4] = -0.0;
+            vec2_construct(&vec3, sizeof(double), 5, items3, 5);
+            vec2_construct(&vec4, sizeof(double), 5, items4, 0);
+            vec2_construct(&vec5, sizeof(double), 7, items5, 0);
+            vec2_sort_by_key(&vec3, 0, sizeof(double), VEC2_KEY_FLOAT, &vec4);
+            vec2_eytz_build(&vec5, &vec3);
+            /* -0.0 and +0.0 are distinct, and NaN is at an end */
+            ok = true;
+            for (i = 0; i < 5; ++i)
+            {
+                first = vec2_lower_bound_key(&vec3, &items3[i], 0,
+                                             sizeof(double), VEC2_KEY_FLOAT);
+                ok = ok && (first == i);
+                first = vec2_equal_range_key(&vec3, &items3[i], 0,
+                                             sizeof(double), VEC2_KEY_FLOAT,
+                                             &count);
+                ok = ok && (first == i) && (count == 1);
+                first = vec2_eytz_upper_bound_key(&vec5, &items3[i], 0,
+                                                  sizeof(double),
+                                                  VEC2_KEY_FLOAT);
+                ok = ok && (first == i + 1);
+            }
+            assert(ok);
+        }
+
+        /* Eytzinger layout */
+        {
+            static long items3[6] = { 0, 2, 4, 6, 8, 10 }, items4[7];
+            size_t first;
+            VEC2 vec3, vec4;
+            vec2_construct(&vec3, siz, 6, items3, 6);
+            vec2_construct(&vec4, siz, 7, items4, 0);
+            vec2_eytz_build(&vec4, &vec3);
+            /* 6 2 10 0 4 8 */
+            assert(vec2_size(&vec4) == 7 && items4[1] == 6 && items4[3] == 10);
+            n = 5;
+            first = vec2_eytz_lower_bound(&vec4, &n, long_compare);
+            assert(first == 3);
+            n = 8;
+            first = vec2_eytz_upper_bound_key(&vec4, &n, 0, siz,
+                                              VEC2_KEY_SIGNED);
+            assert(first == 5);
+            n = 11;
+            first = vec2_eytz_lower_bound(&vec4, &n, long_compare);
+            assert(first == 6);
+            assert(*(long *)vec2_eytz_at(&vec4, 4) == 8);
+        }
+
+        /* merge and set operations */
+        {
+            static long a4[] = { 1, 3, 3, 5 }, b4[] = { 2, 3, 6 };
+            static long items4[8], items5[8];
+            VEC2 va, vb, vec4, vec5;
+            vec2_construct(&va, siz, 4, a4, 4);
+            vec2_construct(&vb, siz, 3, b4, 3);
+            vec2_construct(&vec4, siz, 8, items4, 0);
+            vec2_construct(&vec5, siz, 8, items5, 0);
+            vec2_merge(&vec4, &va, &vb, long_compare);
+            assert(vec2_size(&vec4) == 7);
+            assert(items4[0] == 1 && items4[3] == 3 && items4[6] == 6);
+            vec2_set_union(&vec4, &va, &vb, long_compare);
+            /* 1 2 3 3 5 6 */
+            assert(vec2_size(&vec4) == 6 && items4[4] == 5);
+            vec2_set_intersection(&vec4, &va, &vb, long_compare);
+            assert(vec2_size(&vec4) == 1 && items4[0] == 3);
+            vec2_set_difference(&vec4, &va, &vb, long_compare);
+            /* 1 3 5 */
+            assert(vec2_size(&vec4) == 3 && items4[1] == 3);
+            vec2_clear(&vec4);
+            vec2_insert_sub(&vec4, 0, &va);
+            vec2_insert_sub(&vec4, 4, &vb);
+            vec2_inplace_merge(&vec4, 4, long_compare, &vec5);
+            assert(vec2_size(&vec4) == 7);
+            assert(items4[1] == 2 && items4[4] == 3 && items4[5] == 5);
+        }
+
+#ifdef VEC2_DIRTY_TRACKING
+        /* dirty tracking */
+        {
+            static long items6[1000];
+            static unsigned char bitmap[VEC2_DIRTY_BITMAP_SIZE(1000, 8, 7)];
+            VEC2 vec6;
+            VEC2_RANGE ranges[4];
+            size_t count, first;
+
+            vec2_construct(&vec6, siz, 1000, items6, 0);
+            vec2_push_back_n(&vec6, 800, NULL);
+            vec2_track_dirty(&vec6, bitmap, 7);     /* 128 bytes per chunk */
+            count = vec2_dirty_ranges(&vec6, ranges, 4);
+            assert(count == 0);
+
+            n = 7;
+            vec2_set_at(&vec6, 9, &n);              /* the chunk 0 */
+            vec2_set_at(&vec6, 100, &n);            /* the chunk 6 */
+            vec2_set_at(&vec6, 103, &n);
+            vec2_erase(&vec6, 795);                 /* the chunk 49 */
+            vec2_push_back(&vec6, &n);
+            count = vec2_dirty_ranges(&vec6, ranges, 2);
+            assert(count == 2);
+            assert(ranges[0].offset == 0 && ranges[0].size == 128);
+            assert(ranges[1].offset == 6 * 128 && ranges[1].size == 128);
+            count = vec2_dirty_ranges(&vec6, ranges, 4);
+            assert(count == 1);
+            assert(ranges[0].offset == 49 * 128 && ranges[0].size == 128);
+            count = vec2_dirty_ranges(&vec6, ranges, 4);
+            assert(count == 0);
+
+            /* the last chunk is clipped to the block */
+            vec2_resize(&vec6, 1000, NULL);
+            count = vec2_dirty_ranges(&vec6, ranges, 4);
+            assert(count == 1);
+            assert(ranges[0].offset == 800 * 8);
+            assert(ranges[0].size == 200 * 8);
+
+            vec2_erase_range(&vec6, 0, 1);
+            count = vec2_dirty_ranges(&vec6, ranges, 4);
+            assert(count == 1);
+            assert(ranges[0].offset == 0 && ranges[0].size == 1000 * 8);
+
+            /* the generated sorts and updates of vec2_sort.h */
+            vec2_resize(&vec6, 800, NULL);
+            vec2_dirty_ranges(&vec6, ranges, 4);
+            long_sort_vec2(&vec6);
+            count = vec2_dirty_ranges(&vec6, ranges, 4);
+            assert(count == 1 && ranges[0].size == 800 * 8);
+            n = 3;                                  /* between 0 and 7 */
+            first = long_search_upper_bound(items6, 800, &n);
+            long_search_insert_sorted(&vec6, &n);
+            count = vec2_dirty_ranges(&vec6, ranges, 4);
+            assert(count == 1 && ranges[0].offset == first * 8 / 128 * 128);
+            assert(ranges[0].offset + ranges[0].size == 51 * 128);
+            first = long_search_equal_range(items6, 801, &n, &count);
+            long_search_erase_key(&vec6, &n);
+            count = vec2_dirty_ranges(&vec6, ranges, 4);
+            assert(count == 1 && ranges[0].offset == first * 8 / 128 * 128);
+        }
+#endif  /* def VEC2_DIRTY_TRACKING */
+
+        /* type-specialized vec2 */
+        {
+            LONGVEC lv;
+            size_t count;
+            LONGVEC_construct(&lv, 100, items1, 0);
+            n = 2;
+            LONGVEC_push_back(&lv, &n);
+            n = 1;
+            LONGVEC_insert(&lv, 0, 2, &n);
+            LONGVEC_sort(&lv, long_compare);
+            assert(vec2_size(&lv) == 3);
+            assert(lv.items[0] == 1 && lv.items[1] == 1 && lv.items[2] == 2);
+            LONGVEC_erase(&lv, 1);
+            assert(vec2_size(&lv) == 2 && *LONGVEC_back(&lv) == 2);
+            s_pred_calls = 0;
+            s_erase_first = 1;
+            count = LONGVEC_erase_if(&lv, long_erase_first);
+            assert(count == 1 && vec2_size(&lv) == 1);
+            assert(s_pred_calls == 2);
+            LONGVEC_destroy(&lv);
+        }
+
+        /* the sorts of vec2_sort.h and the stable sort */
+        {
+            static long items3[100], items4[100];
+            static PAIR pairs[100], scratch[100];
+            size_t i, bad;
+            bool ok;
+            VEC2 vec3, vec4, vec5;
+
+            for (i = 0; i < 100; ++i)
+            {
+                items3[i] = (long)((i * 7919U) % 101U) - 50;
+                items4[i] = items3[99 - i];
+            }
+            long_sort(items3, 100);
+            vec2_construct(&vec3, siz, 100, items4, 100);
+            long_sort_vec2(&vec3);
+            ok = true;
+            for (i = 1; i < 100; ++i)
+            {
+                ok = ok && (items3[i - 1] <= items3[i]);
+                ok = ok && (items4[i - 1] <= items4[i]);
+            }
+            assert(ok);
+
+            pair_fill(pairs, 100);
+            pair_sort_stable(pairs, 100, scratch);
+            ok = pair_stable(pairs, 100);
+            assert(ok);
+
+            pair_fill(pairs, 100);
+            vec2_construct(&vec4, sizeof(PAIR), 100, pairs, 100);
+            vec2_construct(&vec5, sizeof(PAIR), 100, scratch, 0);
+            pair_sort_stable_vec2(&vec4, &vec5);
+            ok = pair_stable(pairs, 100);
+            assert(ok);
+
+            pair_fill(pairs, 100);
+            vec2_stable_sort(&vec4, pair_compare, &vec5);
+            ok = pair_stable(pairs, 100);
+            assert(ok);
+
+    #ifndef VEC2_QUICK_BUT_RISKY
+            /* the scratch is too small */
+            pair_fill(pairs, 100);
+            vec2_construct(&vec5, sizeof(PAIR), 99, scratch, 0);
+            bad = s_status_bad;
+            ok = !vec2_stable_sort(&vec4, pair_compare, &vec5);
+            assert(ok && s_status_bad == bad + 1);
+            ok = (pairs[1].tag == 1);               /* untouched */
+            assert(ok);
+    #else
+            (void)bad;
+    #endif
+        }
+
+        /* no unexpected bad status */
+    #ifndef VEC2_QUICK_BUT_RISKY
+        assert(s_status_bad == 1);
+    #else
+        assert(s_status_bad == 0);
+    #endif
+
         return 0;
     } /* main */
 #endif  /* def VEC2_TEST */
 
 /****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_C */
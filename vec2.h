@@ -26,14 +26,46 @@ typedef struct VEC2
     size_t  num_items;      /* number of items alive */
     size_t  capacity;       /* number of items allocated */
     size_t  size_per_item;  /* the size of one item */
+#ifdef VEC2_DIRTY_TRACKING
+    unsigned char * dirty;  /* the bitmap of the modified chunks, or NULL */
+    size_t  dirty_shift;    /* log2 of the bytes of a chunk */
+#endif
 } VEC2, *PVEC2;
 
+#ifdef VEC2_DIRTY_TRACKING
+    /* a span of bytes in the fixed block */
+    typedef struct VEC2_RANGE
+    {
+        size_t  offset;
+        size_t  size;
+    } VEC2_RANGE;
+#endif
+
 /* NOTE: VEC2_FOREACH_FN returns false to cancel operation. */
 typedef bool (*VEC2_FOREACH_FN)(size_t index0, void *pitem);
 
+/* NOTE: VEC2_BATCH_FN gets count items from index0 at pitems.
+ *       It returns false to cancel operation. */
+typedef bool (*VEC2_BATCH_FN)(size_t index0, void *pitems, size_t count);
+
+/* NOTE: VEC2_PREDICATE_FN returns true to choose the item. */
+typedef bool (*VEC2_PREDICATE_FN)(size_t index0, const void *pitem);
+
 /* NOTE: VEC2_ITEM_COMPARE_FN returns 0 if equal; -1 if less; 1 if greater. */
 typedef int (*VEC2_ITEM_COMPARE_FN)(const void *pitem1, const void *pitem2);
 
+/* NOTE: VEC2_NPOS means "not found". */
+#define VEC2_NPOS   ((size_t)-1)
+
+/* the type of the key in an item */
+typedef enum VEC2_KEY_TYPE
+{
+    VEC2_KEY_UNSIGNED,      /* unsigned integer in native byte order */
+    VEC2_KEY_SIGNED,        /* signed integer in native byte order */
+    VEC2_KEY_FLOAT,         /* float or double in native byte order */
+    VEC2_KEY_BYTES          /* bytes in memcmp order (i.e. big-endian) */
+} VEC2_KEY_TYPE;
+
 /****************************************************************************/
 /* Do you wanna status return? */
 
@@ -51,6 +83,65 @@ typedef int (*VEC2_ITEM_COMPARE_FN)(const void *pitem1, const void *pitem2);
     #define VEC2_STATUS_RETURN(ret)      return ret
 #endif
 
+/****************************************************************************/
+/* inline function */
+
+#ifndef VEC2_INLINE_FN
+    #if defined(__cplusplus) || \
+        (defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 199901L))
+        #define VEC2_INLINE_FN  static inline
+    #elif defined(__GNUC__)
+        #define VEC2_INLINE_FN  static __inline__
+    #elif defined(_MSC_VER)
+        #define VEC2_INLINE_FN  static __inline
+    #else
+        #define VEC2_INLINE_FN  static
+    #endif
+#endif  /* ndef VEC2_INLINE_FN */
+
+/****************************************************************************/
+/* header-only build */
+
+/*
+ * NOTE: If VEC2_INLINE is defined, vec2.h includes vec2.c and all the
+ *       functions become static inline. You don't have to link vec2.c then.
+ */
+#ifdef VEC2_INLINE
+    #define VEC2_API    VEC2_INLINE_FN
+#else
+    #define VEC2_API    /* empty */
+#endif
+
+/****************************************************************************/
+/* SIMD */
+
+/* NOTE: #define VEC2_NO_SIMD to disable SIMD code. */
+#ifndef VEC2_NO_SIMD
+    #if defined(__SSE2__) || defined(_M_X64) || \
+        (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+        #define VEC2_USE_SSE2
+    #endif
+    #if defined(__SSE4_2__)
+        #define VEC2_USE_SSE42
+    #endif
+    #if defined(__AVX2__)
+        #define VEC2_USE_AVX2
+    #endif
+#endif  /* ndef VEC2_NO_SIMD */
+
+/* NOTE: VEC2_PREFETCH(ptr) hints to load the cache line at ptr. */
+#ifndef VEC2_PREFETCH
+    #if defined(__GNUC__) || defined(__clang__)
+        #define VEC2_PREFETCH(ptr)  __builtin_prefetch(ptr)
+    #elif defined(_MSC_VER) && defined(VEC2_USE_SSE2)
+        #include <xmmintrin.h>
+        #define VEC2_PREFETCH(ptr) \
+            _mm_prefetch((const char *)(ptr), _MM_HINT_T0)
+    #else
+        #define VEC2_PREFETCH(ptr)  /* empty */
+    #endif
+#endif  /* ndef VEC2_PREFETCH */
+
 /****************************************************************************/
 /* C/C++ switching */
 
@@ -64,62 +155,244 @@ extern "C"
 
 #define vec2_init(pv,spi)   ERROR_You_cannot_use_vec2_init_You_lose
 
-vec2_bool vec2_construct(PVEC2 pv, size_t size_per_item,
-                         size_t capacity, void *items, size_t num_items);
-void vec2_destroy(PVEC2 pv);
-void vec2_clear(PVEC2 pv);
+VEC2_API vec2_bool
+vec2_construct(PVEC2 pv, size_t size_per_item,
+               size_t capacity, void *items, size_t num_items);
+VEC2_API void vec2_destroy(PVEC2 pv);
+VEC2_API void vec2_clear(PVEC2 pv);
 
 /* NOTE: You cannot use vec2_new(). */
 #define vec2_new(spi)       ERROR_You_cannot_use_vec2_new_You_lose
 /* NOTE: You cannot use vec2_delete(). */
 #define vec2_delete(pv)     ERROR_You_cannot_use_vec2_delete_You_lose
 
-void *vec2_get_at(PVEC2 pv, size_t index0);
-void vec2_set_at(PVEC2 pv, size_t index0, const void *pitem);
+VEC2_API void *vec2_get_at(PVEC2 pv, size_t index0);
+VEC2_API void vec2_set_at(PVEC2 pv, size_t index0, const void *pitem);
 
-vec2_bool vec2_copy(PVEC2 dest, const VEC2 *src);
+VEC2_API vec2_bool vec2_copy(PVEC2 dest, const VEC2 *src);
 
-vec2_bool vec2_assign(PVEC2 pv, size_t count, const void *pitem,
-                      size_t size_per_item);
+VEC2_API vec2_bool
+vec2_assign(PVEC2 pv, size_t count, const void *pitem, size_t size_per_item);
 
-vec2_bool vec2_resize(PVEC2 pv, size_t count, const void *pitem);
-vec2_bool vec2_reserve(PVEC2 pv, size_t capacity);
-vec2_bool vec2_reserve_2(PVEC2 pv, size_t capacity, size_t size_per_item);
-void vec2_shrink_to_fit(PVEC2 pv);
+VEC2_API vec2_bool vec2_resize(PVEC2 pv, size_t count, const void *pitem);
+VEC2_API vec2_bool vec2_reserve(PVEC2 pv, size_t capacity);
+VEC2_API vec2_bool
+vec2_reserve_2(PVEC2 pv, size_t capacity, size_t size_per_item);
+VEC2_API void vec2_shrink_to_fit(PVEC2 pv);
 
-void vec2_foreach(PVEC2 pv, VEC2_FOREACH_FN fn);
-void vec2_foreach_reverse(PVEC2 pv, VEC2_FOREACH_FN fn);
+VEC2_API void vec2_foreach(PVEC2 pv, VEC2_FOREACH_FN fn);
+VEC2_API void vec2_foreach_reverse(PVEC2 pv, VEC2_FOREACH_FN fn);
 
-void
+VEC2_API void
 vec2_foreach_range(PVEC2 pv, VEC2_FOREACH_FN fn, size_t index0, size_t count);
 
-void *vec2_find(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare);
+/* NOTE: vec2_foreach_batch() calls fn with the spans of batch_hint items.
+ *       If batch_hint is zero, the spans are VEC2_BATCH_BYTES long. */
+#ifndef VEC2_BATCH_BYTES
+    #define VEC2_BATCH_BYTES    16384   /* to fit L1 cache */
+#endif
+VEC2_API void
+vec2_foreach_batch(PVEC2 pv, VEC2_BATCH_FN fn, size_t batch_hint);
+
+VEC2_API void *
+vec2_find(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare);
+
+/*
+ * byte-equality search (no callback)
+ * NOTE: The key is key_size bytes at key_offset in each item.
+ *       vec2_find_key() returns the index of the first matching item at or
+ *       after index0, or VEC2_NPOS. vec2_find_all_key() stores the indexes
+ *       of the matching items (max_indexes at most) and returns the number.
+ */
+VEC2_API void *vec2_find_bytes(PVEC2 pv, const void *pitem);
+VEC2_API size_t
+vec2_find_key(const VEC2 *pv, size_t index0, const void *key,
+              size_t key_offset, size_t key_size);
+VEC2_API size_t
+vec2_count_key(const VEC2 *pv, const void *key,
+               size_t key_offset, size_t key_size);
+VEC2_API size_t
+vec2_find_all_key(const VEC2 *pv, const void *key, size_t key_offset,
+                  size_t key_size, size_t *indexes, size_t max_indexes);
 
 #ifndef MISRA_C
     /* NOTE: vec2_bsearch() and vec2_sort() aren't available in MISRA-C. */
-    void *
+    VEC2_API void *
     vec2_bsearch(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare);
 
-    void vec2_sort(PVEC2 pv, VEC2_ITEM_COMPARE_FN compare);
+    VEC2_API void vec2_sort(PVEC2 pv, VEC2_ITEM_COMPARE_FN compare);
 #endif  /* ndef MISRA_C */
 
-vec2_bool vec2_insert(PVEC2 pv, size_t index0, size_t count, const void *pitem);
-vec2_bool vec2_insert_sub(PVEC2 pv, size_t index0, const VEC2 *psubvec);
+/*
+ * sorted vectors
+ * NOTE: The items must be sorted by compare, or by the key in the order of
+ *       vec2_sort_by_key(). vec2_lower_bound() returns the index of the
+ *       first item not less than *pitem, and vec2_upper_bound() the first
+ *       item greater than *pitem. vec2_equal_range() returns the index of
+ *       the first equal item and stores the number of the equal items to
+ *       *pcount. vec2_insert_sorted() inserts *pitem after the equal items.
+ *       vec2_erase_key() erases the equal items and returns the number.
+ */
+VEC2_API size_t
+vec2_lower_bound(const VEC2 *pv, const void *pitem,
+                 VEC2_ITEM_COMPARE_FN compare);
+VEC2_API size_t
+vec2_upper_bound(const VEC2 *pv, const void *pitem,
+                 VEC2_ITEM_COMPARE_FN compare);
+VEC2_API size_t
+vec2_equal_range(const VEC2 *pv, const void *pitem,
+                 VEC2_ITEM_COMPARE_FN compare, size_t *pcount);
+VEC2_API size_t
+vec2_lower_bound_key(const VEC2 *pv, const void *key, size_t key_offset,
+                     size_t key_size, VEC2_KEY_TYPE key_type);
+VEC2_API size_t
+vec2_upper_bound_key(const VEC2 *pv, const void *key, size_t key_offset,
+                     size_t key_size, VEC2_KEY_TYPE key_type);
+VEC2_API size_t
+vec2_equal_range_key(const VEC2 *pv, const void *key, size_t key_offset,
+                     size_t key_size, VEC2_KEY_TYPE key_type,
+                     size_t *pcount);
+VEC2_API vec2_bool
+vec2_insert_sorted(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare);
+VEC2_API size_t
+vec2_erase_key(PVEC2 pv, const void *pitem, VEC2_ITEM_COMPARE_FN compare);
 
-vec2_bool vec2_erase(PVEC2 pv, size_t index0);
-vec2_bool vec2_erase_range(PVEC2 pv, size_t index0, size_t count);
+/*
+ * Eytzinger layout
+ * NOTE: vec2_eytz_build() copies the sorted items of src to dest in
+ *       Eytzinger (breadth-first) order for read-mostly tables. dest is a
+ *       fixed block of the same item size that can hold size(src) + 1
+ *       items; item 0 is padding, so that the descendants of an item share
+ *       cache lines if dest is aligned to a cache line. The search functions
+ *       of dest work like the ones of the sorted vectors and return the
+ *       index in src. vec2_eytz_at() returns the item of dest at the index
+ *       in src. Rebuild dest after src changes.
+ */
+VEC2_API vec2_bool vec2_eytz_build(PVEC2 dest, const VEC2 *src);
+VEC2_API size_t
+vec2_eytz_lower_bound(const VEC2 *pv, const void *pitem,
+                      VEC2_ITEM_COMPARE_FN compare);
+VEC2_API size_t
+vec2_eytz_upper_bound(const VEC2 *pv, const void *pitem,
+                      VEC2_ITEM_COMPARE_FN compare);
+VEC2_API size_t
+vec2_eytz_lower_bound_key(const VEC2 *pv, const void *key,
+                          size_t key_offset, size_t key_size,
+                          VEC2_KEY_TYPE key_type);
+VEC2_API size_t
+vec2_eytz_upper_bound_key(const VEC2 *pv, const void *key,
+                          size_t key_offset, size_t key_size,
+                          VEC2_KEY_TYPE key_type);
+VEC2_API void *vec2_eytz_at(PVEC2 pv, size_t index0);
 
-vec2_bool vec2_push_back(PVEC2 pv, const void *pitem);
-vec2_bool vec2_pop_back(PVEC2 pv);
+/*
+ * merge and set operations
+ * NOTE: a and b must be sorted by compare. The functions store the result
+ *       to dest (which must not be a or b) in one pass and keep it sorted.
+ *       The equal items are treated as a multiset like std::set_union().
+ *       If dest gets full, they return false.
+ *       vec2_inplace_merge() merges the sorted items [0, mid) and
+ *       [mid, size) of pv. scratch can hold mid items.
+ */
+VEC2_API vec2_bool
+vec2_merge(PVEC2 dest, const VEC2 *a, const VEC2 *b,
+           VEC2_ITEM_COMPARE_FN compare);
+VEC2_API vec2_bool
+vec2_set_union(PVEC2 dest, const VEC2 *a, const VEC2 *b,
+               VEC2_ITEM_COMPARE_FN compare);
+VEC2_API vec2_bool
+vec2_set_intersection(PVEC2 dest, const VEC2 *a, const VEC2 *b,
+                      VEC2_ITEM_COMPARE_FN compare);
+VEC2_API vec2_bool
+vec2_set_difference(PVEC2 dest, const VEC2 *a, const VEC2 *b,
+                    VEC2_ITEM_COMPARE_FN compare);
+VEC2_API vec2_bool
+vec2_inplace_merge(PVEC2 pv, size_t mid, VEC2_ITEM_COMPARE_FN compare,
+                   PVEC2 scratch);
+
+/*
+ * radix sort
+ * NOTE: vec2_sort_by_key() sorts the items by the key of key_size bytes at
+ *       key_offset in each item. It's stable. scratch is a fixed block of
+ *       the same item size that can hold all the items.
+ */
+VEC2_API vec2_bool
+vec2_sort_by_key(PVEC2 pv, size_t key_offset, size_t key_size,
+                 VEC2_KEY_TYPE key_type, PVEC2 scratch);
 
-void vec2_swap(PVEC2 pv1, PVEC2 pv2);
+/* NOTE: vec2_stable_sort() is a merge sort. scratch is a fixed block of
+ *       the same item size that can hold all the items. */
+VEC2_API vec2_bool
+vec2_stable_sort(PVEC2 pv, VEC2_ITEM_COMPARE_FN compare, PVEC2 scratch);
+
+VEC2_API vec2_bool
+vec2_insert(PVEC2 pv, size_t index0, size_t count, const void *pitem);
+VEC2_API vec2_bool
+vec2_insert_sub(PVEC2 pv, size_t index0, const VEC2 *psubvec);
+
+VEC2_API vec2_bool vec2_erase(PVEC2 pv, size_t index0);
+VEC2_API vec2_bool vec2_erase_range(PVEC2 pv, size_t index0, size_t count);
+
+/* NOTE: vec2_erase_unordered() and vec2_erase_range_unordered() fill the
+ *       hole with the last items. They don't keep the order. */
+VEC2_API vec2_bool vec2_erase_unordered(PVEC2 pv, size_t index0);
+VEC2_API vec2_bool
+vec2_erase_range_unordered(PVEC2 pv, size_t index0, size_t count);
+
+/*
+ * bulk erase
+ * NOTE: vec2_erase_if() erases the items that pred chooses and returns the
+ *       number of the erased items. vec2_erase_indices() erases the items at
+ *       indexes (sorted in ascending order; duplicates are ignored). Both
+ *       keep the order and move each surviving item once at most.
+ */
+VEC2_API size_t vec2_erase_if(PVEC2 pv, VEC2_PREDICATE_FN pred);
+VEC2_API vec2_bool
+vec2_erase_indices(PVEC2 pv, const size_t *indexes, size_t count);
+
+VEC2_API vec2_bool vec2_push_back(PVEC2 pv, const void *pitem);
+VEC2_API vec2_bool vec2_pop_back(PVEC2 pv);
+
+/* NOTE: vec2_append() and vec2_push_back_n() return the number of items
+ *       added. It is less than count if the fixed block gets full. */
+VEC2_API size_t vec2_append(PVEC2 pv, const void *items, size_t count);
+VEC2_API size_t vec2_push_back_n(PVEC2 pv, size_t count, const void *pitem);
+
+VEC2_API void vec2_swap(PVEC2 pv1, PVEC2 pv2);
+
+/*
+ * dirty tracking
+ * NOTE: If VEC2_DIRTY_TRACKING is defined, vec2_track_dirty() starts to
+ *       record the chunks of (1 << chunk_shift) bytes of the block that
+ *       the vec2 functions modify, to the bitmap of
+ *       VEC2_DIRTY_BITMAP_SIZE() bytes. A NULL bitmap stops it.
+ *       vec2_dirty_ranges() stores the byte spans of the modified chunks
+ *       (max_ranges at most), clears them, and returns the number. If it
+ *       returns max_ranges, call it again for the rest. Call
+ *       vec2_mark_dirty() after writing the items through the pointers
+ *       (vec2_get_at(), the callbacks of vec2_foreach(), etc.). The items
+ *       erased from the end aren't marked; see num_items.
+ *       VEC2_DIRTY_TRACKING changes VEC2. Define it for all the sources.
+ */
+#ifdef VEC2_DIRTY_TRACKING
+    #define VEC2_DIRTY_BITMAP_SIZE(capacity,size_per_item,chunk_shift) \
+        (((((capacity) * (size_per_item)) >> (chunk_shift)) + 8U) / 8U)
+
+    VEC2_API void
+    vec2_track_dirty(PVEC2 pv, unsigned char *bitmap, size_t chunk_shift);
+    VEC2_API void vec2_mark_dirty(PVEC2 pv, size_t index0, size_t count);
+    VEC2_API size_t
+    vec2_dirty_ranges(PVEC2 pv, VEC2_RANGE *ranges, size_t max_ranges);
+#else
+    #define vec2_mark_dirty(pv,index0,count)    /* empty */
+#endif
 
 /* validation for debugging */
-bool vec2_valid(const VEC2 *pv);
+VEC2_API bool vec2_valid(const VEC2 *pv);
 
 #ifndef NDEBUG
-    void *vec2_item(PVEC2 pv, size_t index0);
-    const void *vec2_const_item(const VEC2 *pv, size_t index0);
+    VEC2_API void *vec2_item(PVEC2 pv, size_t index0);
+    VEC2_API const void *vec2_const_item(const VEC2 *pv, size_t index0);
 #endif
 
 /****************************************************************************/
@@ -166,6 +439,13 @@ bool vec2_valid(const VEC2 *pv);
 } /* extern "C" */
 #endif
 
+/****************************************************************************/
+/* header-only build */
+
+#ifdef VEC2_INLINE
+    #include "vec2.c"
+#endif
+
 /****************************************************************************/
 
 #endif  /* ndef KATAHIROMZ_VEC2_H */
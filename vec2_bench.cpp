@@ -0,0 +1,1437 @@
+/****************************************************************************/
+/* vec2_bench.cpp --- benchmark of vec2 (fixed block vector for C)          */
+/****************************************************************************/
+/*
+ * This compares each vec2 operation against a plain array and a
+ * std::vector with reserved capacity, sweeping the item size and the
+ * number of items (from L1-sized to much larger than LLC).
+ *
+ * How to build:
+ *
+ *     cc -O2 -DNDEBUG -c vec2.c vec2_thread.c vec2_hash.c \
+ *         vec2_ring.c vec2_gap.c vec2_queue.c vec2_io.c vec2_soa.c
+ *     c++ -O2 -DNDEBUG -pthread vec2_bench.cpp vec2.o vec2_thread.o \
+ *         vec2_hash.o vec2_ring.o vec2_gap.o vec2_queue.o vec2_io.o \
+ *         vec2_soa.o -o vec2_bench
+ *
+ *     cc -O2 -DNDEBUG -DVEC2_QUICK_BUT_RISKY -c vec2.c vec2_thread.c \
+ *         vec2_hash.c vec2_ring.c vec2_gap.c vec2_queue.c vec2_io.c \
+ *         vec2_soa.c
+ *     c++ -O2 -DNDEBUG -DVEC2_QUICK_BUT_RISKY -pthread vec2_bench.cpp \
+ *         vec2.o vec2_thread.o vec2_hash.o vec2_ring.o vec2_gap.o \
+ *         vec2_queue.o vec2_io.o vec2_soa.o -o vec2_bench_risky
+ *
+ * Usage:
+ *
+ *     vec2_bench [max-bytes [operation]]
+ *
+ * max-bytes is the largest block to test (default: 64M). "operation"
+ * limits the benchmark to one operation such as "push_back".
+ */
+
+#include "vec2.h"
+#include "vec2_sort.h"
+#include "vec2_thread.h"
+#include "vec2_hash.h"
+#include "vec2_ring.h"
+#include "vec2_gap.h"
+#include "vec2_queue.h"
+#include "vec2_io.h"
+#include "vec2_soa.h"
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+/****************************************************************************/
+/* settings */
+
+/* item sizes */
+static const size_t s_item_sizes[] = { 1, 4, 8, 16, 64, 256 };
+
+/* block sizes in bytes: L1, L2, LLC and beyond */
+static const size_t s_block_bytes[] =
+{
+    16 * 1024, 256 * 1024, 4 * 1024 * 1024, 64 * 1024 * 1024
+};
+
+static const double s_min_seconds = 0.02;   /* minimum time per test */
+static const size_t s_max_sort_items = 4 * 1024 * 1024;
+static const size_t s_bsearch_count = 100000;
+static const size_t s_sub_count = 16;       /* for insert_sub/erase_range */
+static const size_t s_moved_bytes = 64 * 1024 * 1024;
+
+static size_t s_max_bytes = 64 * 1024 * 1024;
+static const char *s_operation = NULL;
+
+/* the result sink not to be optimized out */
+static volatile size_t s_sink = 0;
+
+/****************************************************************************/
+/* items */
+
+template <size_t N>
+struct Item
+{
+    unsigned char bytes[N];
+};
+
+/* the key is the first 8 bytes at most */
+template <size_t N>
+inline int key_compare(const Item<N>& a, const Item<N>& b)
+{
+    return memcmp(a.bytes, b.bytes, (N < 8) ? N : 8);
+}
+
+template <size_t N>
+inline bool operator==(const Item<N>& a, const Item<N>& b)
+{
+    return memcmp(a.bytes, b.bytes, N) == 0;
+}
+
+template <size_t N>
+inline bool key_less(const Item<N>& a, const Item<N>& b)
+{
+    return key_compare(a, b) < 0;
+}
+
+template <size_t N>
+int item_compare(const void *x, const void *y)
+{
+    return key_compare(*(const Item<N> *)x, *(const Item<N> *)y);
+}
+
+/* the callbacks of the iterations */
+static size_t s_foreach_sum = 0;
+
+template <size_t N>
+bool foreach_sum(size_t index0, void *pitem)
+{
+    (void)index0;
+    s_foreach_sum += ((const Item<N> *)pitem)->bytes[N - 1];
+    return true;
+}
+
+template <size_t N>
+bool batch_sum(size_t index0, void *pitems, size_t count)
+{
+    const Item<N> *a = (const Item<N> *)pitems;
+    size_t i, sum = 0;
+    (void)index0;
+    for (i = 0; i < count; ++i)
+        sum += a[i].bytes[N - 1];
+    s_foreach_sum += sum;
+    return true;
+}
+
+/* erases about a quarter of the items */
+template <size_t N>
+bool erase_pred(size_t index0, const void *pitem)
+{
+    (void)index0;
+    return (((const Item<N> *)pitem)->bytes[N - 1] & 3) == 0;
+}
+
+/* the inlined-comparator sorts and searches */
+#define ITEM_LESS(a,b)  key_less(*(a), *(b))
+
+template <size_t N> void pdq_sort(PVEC2 pv);
+template <size_t N>
+size_t inl_lower_bound(const Item<N> *items, size_t count, const Item<N> *key);
+
+#define DECLARE_ITEM_SORT(N) \
+    VEC2_DECLARE_SORT(pdq_sort_##N, Item<N>, ITEM_LESS) \
+    VEC2_DECLARE_SEARCH(search_##N, Item<N>, ITEM_LESS) \
+    template <> void pdq_sort<N>(PVEC2 pv) { pdq_sort_##N##_vec2(pv); } \
+    template <> size_t \
+    inl_lower_bound<N>(const Item<N> *items, size_t count, \
+                       const Item<N> *key) \
+    { \
+        return search_##N##_lower_bound(items, count, key); \
+    }
+
+DECLARE_ITEM_SORT(1)
+DECLARE_ITEM_SORT(4)
+DECLARE_ITEM_SORT(8)
+DECLARE_ITEM_SORT(16)
+DECLARE_ITEM_SORT(64)
+DECLARE_ITEM_SORT(256)
+
+static size_t s_random_seed = 0x12345678;
+
+static size_t random_value(void)
+{
+    /* xorshift */
+    size_t x = s_random_seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    s_random_seed = x;
+    return x;
+}
+
+template <size_t N>
+static void random_items(std::vector<Item<N> >& items, size_t count)
+{
+    size_t i, k;
+    items.resize(count);
+    for (i = 0; i < count; ++i)
+    {
+        for (k = 0; k < N; ++k)
+        {
+            items[i].bytes[k] = (unsigned char)random_value();
+        }
+        /* see Bench::m_missing */
+        items[i].bytes[0] %= 0xFE;
+    }
+}
+
+/****************************************************************************/
+/* measurement */
+
+typedef std::chrono::steady_clock bench_clock;
+
+/* runs setup() and run() until s_min_seconds passes. run() does ops
+   operations. returns nanoseconds per operation. */
+template <typename SETUP, typename RUN>
+static double measure(size_t ops, SETUP setup, RUN run)
+{
+    double total = 0;
+    size_t reps = 0;
+    do
+    {
+        setup();
+        bench_clock::time_point t0 = bench_clock::now();
+        run();
+        bench_clock::time_point t1 = bench_clock::now();
+        total += std::chrono::duration<double>(t1 - t0).count();
+        ++reps;
+    } while (total < s_min_seconds);
+
+    return total * 1e9 / (double)(reps * ops);
+}
+
+static bool is_enabled(const char *operation)
+{
+    return s_operation == NULL || strcmp(s_operation, operation) == 0;
+}
+
+static void
+report(const char *operation, const char *impl, size_t item_size,
+       size_t count, double ns_per_op, size_t bytes_per_op)
+{
+    double mb_per_sec = (double)bytes_per_op * 1e3 / ns_per_op;
+    printf("%-12s %-8s %5d %10lu %12.2f %12.1f\n",
+           operation, impl, (int)item_size, (unsigned long)count,
+           ns_per_op, mb_per_sec);
+    fflush(stdout);
+}
+
+static void nothing(void)
+{
+}
+
+/****************************************************************************/
+/* benchmark for one item size and one count */
+
+template <size_t N>
+struct Bench
+{
+    typedef Item<N> T;
+
+    size_t              m_count;
+    size_t              m_capacity;
+    std::vector<T>      m_source;       /* random items */
+    std::vector<T>      m_sorted;       /* sorted m_source */
+    std::vector<T>      m_sub;          /* s_sub_count items */
+    std::vector<T>      m_array;        /* the plain array */
+    std::vector<T>      m_array2;
+    std::vector<T>      m_block;        /* the fixed block of vec2 */
+    std::vector<T>      m_block2;
+    std::vector<T>      m_vector;       /* the std::vector */
+    std::vector<T>      m_vector2;
+    VEC2                m_vec;
+    VEC2                m_vec2;
+    VEC2                m_subvec;
+    T                   m_item;
+    T                   m_missing;
+
+    explicit Bench(size_t count) : m_count(count)
+    {
+        m_capacity = count + moved_ops() * s_sub_count;
+        random_items(m_source, count);
+        m_sorted = m_source;
+        std::sort(m_sorted.begin(), m_sorted.end(), key_less<N>);
+        random_items(m_sub, s_sub_count);
+        m_array.resize(m_capacity);
+        m_array2.resize(m_capacity);
+        m_block.resize(m_capacity);
+        m_block2.resize(m_capacity);
+        m_vector.reserve(m_capacity);
+        m_vector2.reserve(m_capacity);
+        memset(&m_item, 0x5A, sizeof(m_item));
+        memset(&m_missing, 0xFF, sizeof(m_missing));
+        m_missing.bytes[0] = 0xFE;
+        vec2_construct(&m_vec, N, m_capacity, &m_block[0], 0);
+        vec2_construct(&m_vec2, N, m_capacity, &m_block2[0], 0);
+        vec2_construct(&m_subvec, N, s_sub_count, &m_sub[0], s_sub_count);
+    }
+
+    /* the number of the operations that memmove the tail */
+    size_t moved_ops() const
+    {
+        size_t ops = s_moved_bytes / (m_count * N);
+        if (ops < 1)
+            ops = 1;
+        if (ops > 256)
+            ops = 256;
+        return ops;
+    }
+
+    /* the number of the linear searches */
+    size_t find_ops() const
+    {
+        size_t ops = (s_moved_bytes / 4) / (m_count * N);
+        return (ops < 1) ? 1 : ops;
+    }
+
+    void load_source()
+    {
+        memcpy(&m_array[0], &m_source[0], m_count * N);
+        memcpy(&m_block[0], &m_source[0], m_count * N);
+        m_vec.num_items = m_count;
+        m_vector.assign(m_source.begin(), m_source.end());
+    }
+
+    void load_sorted()
+    {
+        memcpy(&m_array[0], &m_sorted[0], m_count * N);
+        memcpy(&m_block[0], &m_sorted[0], m_count * N);
+        m_vec.num_items = m_count;
+        m_vector.assign(m_sorted.begin(), m_sorted.end());
+    }
+
+    void run()
+    {
+        bench_push_back();
+        bench_append();
+        bench_get();
+        bench_set();
+        bench_foreach();
+        bench_insert();
+        bench_insert_sub();
+        bench_erase();
+        bench_erase_range();
+        bench_fifo();
+        bench_edit();
+        bench_queue();
+        bench_erase_if();
+        bench_find();
+        bench_bsearch();
+        bench_sort();
+        bench_merge();
+        bench_copy();
+        bench_resize();
+        bench_assign();
+        bench_load();
+        bench_stream();
+        bench_column();
+    }
+
+    void bench_push_back()
+    {
+        const char *op = "push_back";
+        size_t i, n = m_count;
+        double ns;
+        if (!is_enabled(op))
+            return;
+
+        ns = measure(n, nothing, [&]() {
+            T *a = &m_array[0];
+            for (i = 0; i < n; ++i)
+                a[i] = m_item;
+            s_sink += a[n - 1].bytes[0];
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, [&]() { vec2_clear(&m_vec); }, [&]() {
+            for (i = 0; i < n; ++i)
+                vec2_push_back(&m_vec, &m_item);
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        /* the uncontended costs of the mutex and the VEC2_SHARED appends */
+        pthread_mutex_t mutex;
+        pthread_mutex_init(&mutex, NULL);
+        ns = measure(n, [&]() { vec2_clear(&m_vec); }, [&]() {
+            for (i = 0; i < n; ++i)
+            {
+                pthread_mutex_lock(&mutex);
+                vec2_push_back(&m_vec, &m_item);
+                pthread_mutex_unlock(&mutex);
+            }
+        });
+        report(op, "vec2_mtx", N, n, ns, N);
+        pthread_mutex_destroy(&mutex);
+
+        VEC2_SHARED shared;
+        ns = measure(n, [&]() {
+            vec2_clear(&m_vec);
+            vec2_shared_construct(&shared, &m_vec);
+        }, [&]() {
+            for (i = 0; i < n; ++i)
+                vec2_shared_push_back(&shared, &m_item);
+            vec2_shared_finish(&shared);
+        });
+        report(op, "vec2_shr", N, n, ns, N);
+
+        ns = measure(n, [&]() { m_vector.clear(); }, [&]() {
+            for (i = 0; i < n; ++i)
+                m_vector.push_back(m_item);
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_append()
+    {
+        const char *op = "append";
+        size_t n = m_count;
+        double ns;
+        if (!is_enabled(op))
+            return;
+
+        ns = measure(n, nothing, [&]() {
+            memcpy(&m_array[0], &m_source[0], n * N);
+            s_sink += m_array[n - 1].bytes[0];
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, [&]() { vec2_clear(&m_vec); }, [&]() {
+            vec2_append(&m_vec, &m_source[0], n);
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        /* one reservation for each run of 64 items */
+        VEC2_SHARED shared;
+        const size_t run = 64;
+        ns = measure(n, [&]() {
+            vec2_clear(&m_vec);
+            vec2_shared_construct(&shared, &m_vec);
+        }, [&]() {
+            size_t i;
+            for (i = 0; i < n; i += run)
+            {
+                vec2_shared_append(&shared, &m_source[i],
+                                   (n - i < run) ? n - i : run);
+            }
+            vec2_shared_finish(&shared);
+        });
+        report(op, "vec2_s64", N, n, ns, N);
+
+        ns = measure(n, [&]() { m_vector.clear(); }, [&]() {
+            m_vector.insert(m_vector.end(), m_source.begin(), m_source.end());
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_get()
+    {
+        const char *op = "get_at";
+        size_t i, n = m_count, sum;
+        double ns;
+        if (!is_enabled(op))
+            return;
+        load_source();
+
+        ns = measure(n, nothing, [&]() {
+            const T *a = &m_array[0];
+            for (sum = 0, i = 0; i < n; ++i)
+                sum += a[i].bytes[N - 1];
+            s_sink += sum;
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            for (sum = 0, i = 0; i < n; ++i)
+                sum += ((const T *)vec2_get_at(&m_vec, i))->bytes[N - 1];
+            s_sink += sum;
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            for (sum = 0, i = 0; i < n; ++i)
+                sum += m_vector[i].bytes[N - 1];
+            s_sink += sum;
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_foreach()
+    {
+        const char *op = "foreach";
+        size_t i, n = m_count, sum;
+        double ns;
+        if (!is_enabled(op))
+            return;
+        load_source();
+
+        ns = measure(n, nothing, [&]() {
+            const T *a = &m_array[0];
+            for (sum = 0, i = 0; i < n; ++i)
+                sum += a[i].bytes[N - 1];
+            s_sink += sum;
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            vec2_foreach(&m_vec, foreach_sum<N>);
+            s_sink += s_foreach_sum;
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            vec2_foreach_batch(&m_vec, batch_sum<N>, 0);
+            s_sink += s_foreach_sum;
+        });
+        report(op, "vec2_bat", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            sum = 0;
+            std::for_each(m_vector.begin(), m_vector.end(), [&](const T& t) {
+                sum += t.bytes[N - 1];
+            });
+            s_sink += sum;
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_set()
+    {
+        const char *op = "set_at";
+        size_t i, n = m_count;
+        double ns;
+        if (!is_enabled(op))
+            return;
+        load_source();
+
+        ns = measure(n, nothing, [&]() {
+            T *a = &m_array[0];
+            for (i = 0; i < n; ++i)
+                a[i] = m_item;
+            s_sink += a[n - 1].bytes[0];
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            for (i = 0; i < n; ++i)
+                vec2_set_at(&m_vec, i, &m_item);
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            for (i = 0; i < n; ++i)
+                m_vector[i] = m_item;
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_insert()
+    {
+        const char *op = "insert";
+        size_t i, n = m_count, k = moved_ops(), mid = m_count / 2;
+        double ns;
+        if (!is_enabled(op))
+            return;
+        load_source();
+
+        ns = measure(k, nothing, [&]() {
+            T *a = &m_array[0];
+            for (i = 0; i < k; ++i)
+            {
+                memmove(&a[mid + 1], &a[mid], (n + i - mid) * N);
+                a[mid] = m_item;
+            }
+        });
+        report(op, "array", N, n, ns, (n - mid) * N);
+
+        ns = measure(k, [&]() { m_vec.num_items = n; }, [&]() {
+            for (i = 0; i < k; ++i)
+                vec2_insert(&m_vec, mid, 1, &m_item);
+        });
+        report(op, "vec2", N, n, ns, (n - mid) * N);
+
+        ns = measure(k, [&]() { m_vector.resize(n); }, [&]() {
+            for (i = 0; i < k; ++i)
+                m_vector.insert(m_vector.begin() + mid, m_item);
+        });
+        report(op, "vector", N, n, ns, (n - mid) * N);
+    }
+
+    void bench_insert_sub()
+    {
+        const char *op = "insert_sub";
+        size_t i, n = m_count, k = moved_ops(), mid = m_count / 2;
+        size_t m = s_sub_count;
+        double ns;
+        if (!is_enabled(op))
+            return;
+        load_source();
+
+        ns = measure(k, nothing, [&]() {
+            T *a = &m_array[0];
+            for (i = 0; i < k; ++i)
+            {
+                memmove(&a[mid + m], &a[mid], (n + i * m - mid) * N);
+                memcpy(&a[mid], &m_sub[0], m * N);
+            }
+        });
+        report(op, "array", N, n, ns, (n - mid + m) * N);
+
+        ns = measure(k, [&]() { m_vec.num_items = n; }, [&]() {
+            for (i = 0; i < k; ++i)
+                vec2_insert_sub(&m_vec, mid, &m_subvec);
+        });
+        report(op, "vec2", N, n, ns, (n - mid + m) * N);
+
+        ns = measure(k, [&]() { m_vector.resize(n); }, [&]() {
+            for (i = 0; i < k; ++i)
+                m_vector.insert(m_vector.begin() + mid,
+                                m_sub.begin(), m_sub.end());
+        });
+        report(op, "vector", N, n, ns, (n - mid + m) * N);
+    }
+
+    void bench_erase()
+    {
+        const char *op = "erase";
+        size_t i, n = m_count, k = moved_ops(), mid = m_count / 2;
+        double ns;
+        if (!is_enabled(op) || n <= k + mid)
+            return;
+        load_source();
+
+        ns = measure(k, nothing, [&]() {
+            T *a = &m_array[0];
+            for (i = 0; i < k; ++i)
+                memmove(&a[mid], &a[mid + 1], (n - i - mid - 1) * N);
+        });
+        report(op, "array", N, n, ns, (n - mid) * N);
+
+        ns = measure(k, [&]() { m_vec.num_items = n; }, [&]() {
+            for (i = 0; i < k; ++i)
+                vec2_erase(&m_vec, mid);
+        });
+        report(op, "vec2", N, n, ns, (n - mid) * N);
+
+        ns = measure(k, [&]() { m_vec.num_items = n; }, [&]() {
+            for (i = 0; i < k; ++i)
+                vec2_erase_unordered(&m_vec, mid);
+        });
+        report(op, "vec2_uno", N, n, ns, N);
+
+        ns = measure(k, [&]() { m_vector.resize(n); }, [&]() {
+            for (i = 0; i < k; ++i)
+                m_vector.erase(m_vector.begin() + mid);
+        });
+        report(op, "vector", N, n, ns, (n - mid) * N);
+    }
+
+    void bench_erase_range()
+    {
+        const char *op = "erase_range";
+        size_t i, n = m_count, k = moved_ops(), mid = m_count / 2;
+        size_t m = s_sub_count;
+        double ns;
+        if (!is_enabled(op) || n <= k * m + mid)
+            return;
+        load_source();
+
+        ns = measure(k, nothing, [&]() {
+            T *a = &m_array[0];
+            for (i = 0; i < k; ++i)
+                memmove(&a[mid], &a[mid + m], (n - (i + 1) * m - mid) * N);
+        });
+        report(op, "array", N, n, ns, (n - mid) * N);
+
+        ns = measure(k, [&]() { m_vec.num_items = n; }, [&]() {
+            for (i = 0; i < k; ++i)
+                vec2_erase_range(&m_vec, mid, m);
+        });
+        report(op, "vec2", N, n, ns, (n - mid) * N);
+
+        ns = measure(k, [&]() { m_vec.num_items = n; }, [&]() {
+            for (i = 0; i < k; ++i)
+                vec2_erase_range_unordered(&m_vec, mid, m);
+        });
+        report(op, "vec2_uno", N, n, ns, m * N);
+
+        ns = measure(k, [&]() { m_vector.resize(n); }, [&]() {
+            for (i = 0; i < k; ++i)
+                m_vector.erase(m_vector.begin() + mid,
+                               m_vector.begin() + mid + m);
+        });
+        report(op, "vector", N, n, ns, (n - mid) * N);
+    }
+
+    /* a sliding window: pop the front and push the back */
+    void bench_fifo()
+    {
+        const char *op = "fifo";
+        size_t i, n = m_count, k = moved_ops();
+        double ns;
+        if (!is_enabled(op) || n <= k)
+            return;
+        load_source();
+
+        ns = measure(k, nothing, [&]() {
+            T *a = &m_array[0];
+            for (i = 0; i < k; ++i)
+            {
+                memmove(&a[0], &a[1], (n - 1) * N);
+                a[n - 1] = m_item;
+            }
+        });
+        report(op, "array", N, n, ns, n * N);
+
+        ns = measure(k, [&]() { m_vec.num_items = n; }, [&]() {
+            for (i = 0; i < k; ++i)
+            {
+                vec2_erase(&m_vec, 0);
+                vec2_push_back(&m_vec, &m_item);
+            }
+        });
+        report(op, "vec2", N, n, ns, n * N);
+
+        VEC2_RING ring;
+        vec2_ring_construct(&ring, N, n, &m_block[0], n);
+        ns = measure(k, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+            {
+                vec2_ring_pop_front(&ring);
+                vec2_ring_push_back(&ring, &m_item);
+            }
+        });
+        report(op, "vec2_rng", N, n, ns, N);
+
+        ns = measure(k, [&]() { m_vector.resize(n); }, [&]() {
+            for (i = 0; i < k; ++i)
+            {
+                m_vector.erase(m_vector.begin());
+                m_vector.push_back(m_item);
+            }
+        });
+        report(op, "vector", N, n, ns, n * N);
+    }
+
+    /* inserts and erases near a cursor in the middle */
+    void bench_edit()
+    {
+        const char *op = "edit";
+        size_t i, n = m_count, k = moved_ops(), mid = m_count / 2;
+        double ns;
+        if (!is_enabled(op) || n <= k + mid + 8)
+            return;
+        load_source();
+
+        /* NOTE: every eighth edit erases the item after the cursor */
+        ns = measure(k, [&]() { m_vec.num_items = n; }, [&]() {
+            for (i = 0; i < k; ++i)
+            {
+                if ((i & 7) == 7)
+                    vec2_erase(&m_vec, mid + (i & 7));
+                else
+                    vec2_insert(&m_vec, mid + (i & 7), 1, &m_item);
+            }
+        });
+        report(op, "vec2", N, n, ns, (n - mid) * N);
+
+        VEC2_GAP gap;
+        ns = measure(k, [&]() {
+            /* the gap is already at the cursor in a run of edits */
+            vec2_gap_construct(&gap, N, m_capacity, &m_block[0], n);
+            vec2_gap_set_cursor(&gap, mid);
+        }, [&]() {
+            for (i = 0; i < k; ++i)
+            {
+                if ((i & 7) == 7)
+                    vec2_gap_erase(&gap, mid + (i & 7));
+                else
+                    vec2_gap_insert(&gap, mid + (i & 7), 1, &m_item);
+            }
+        });
+        report(op, "vec2_gap", N, n, ns, N);
+
+        ns = measure(k, [&]() { m_vector.resize(n); }, [&]() {
+            for (i = 0; i < k; ++i)
+            {
+                if ((i & 7) == 7)
+                    m_vector.erase(m_vector.begin() + mid + (i & 7));
+                else
+                    m_vector.insert(m_vector.begin() + mid + (i & 7),
+                                    m_item);
+            }
+        });
+        report(op, "vector", N, n, ns, (n - mid) * N);
+    }
+
+    /* passes the items through a queue in runs, on one thread. the
+       mutex is uncontended, so this is the lower bound of its cost. */
+    void bench_queue()
+    {
+        const char *op = "queue";
+        const size_t run = 64;
+        size_t i, n = m_count - m_count % run, capacity = 1024;
+        double ns;
+        if (!is_enabled(op) || n < run)
+            return;
+        load_source();
+        std::vector<T> block(capacity);
+
+        VEC2_RING ring;
+        pthread_mutex_t mutex;
+        pthread_mutex_init(&mutex, NULL);
+        vec2_ring_construct(&ring, N, capacity, &block[0], 0);
+        ns = measure(n, nothing, [&]() {
+            for (i = 0; i < n; i += run)
+            {
+                pthread_mutex_lock(&mutex);
+                vec2_ring_append(&ring, &m_array[i], run);
+                pthread_mutex_unlock(&mutex);
+                pthread_mutex_lock(&mutex);
+                vec2_ring_read(&ring, 0, run, &m_array2[i]);
+                vec2_ring_pop_front_n(&ring, run);
+                pthread_mutex_unlock(&mutex);
+            }
+        });
+        report(op, "vec2_mtx", N, n, ns, N);
+        pthread_mutex_destroy(&mutex);
+
+        VEC2_SPSC spsc;
+        vec2_spsc_construct(&spsc, N, capacity, &block[0]);
+        ns = measure(n, nothing, [&]() {
+            for (i = 0; i < n; i += run)
+            {
+                vec2_spsc_enqueue(&spsc, &m_array[i], run);
+                vec2_spsc_dequeue(&spsc, &m_array2[i], run);
+            }
+        });
+        report(op, "vec2_spc", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            for (i = 0; i < n; ++i)
+            {
+                vec2_spsc_push(&spsc, &m_array[i]);
+                vec2_spsc_pop(&spsc, &m_array2[i]);
+            }
+        });
+        report(op, "vec2_sp1", N, n, ns, N);
+
+        VEC2_MPMC mpmc;
+        std::vector<VEC2_ATOMIC_SIZE> seqs(capacity);
+        vec2_mpmc_construct(&mpmc, N, capacity, &block[0], &seqs[0]);
+        ns = measure(n, nothing, [&]() {
+            for (i = 0; i < n; i += run)
+            {
+                vec2_mpmc_enqueue(&mpmc, &m_array[i], run);
+                vec2_mpmc_dequeue(&mpmc, &m_array2[i], run);
+            }
+        });
+        report(op, "vec2_mpc", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            for (i = 0; i < n; ++i)
+            {
+                vec2_mpmc_push(&mpmc, &m_array[i]);
+                vec2_mpmc_pop(&mpmc, &m_array2[i]);
+            }
+        });
+        report(op, "vec2_mp1", N, n, ns, N);
+    }
+
+    void bench_erase_if()
+    {
+        const char *op = "erase_if";
+        size_t i, n = m_count;
+        double ns;
+        if (!is_enabled(op))
+            return;
+
+        /* erasing one by one is quadratic; only for the small blocks */
+        if (n * N <= 1024 * 1024)
+        {
+            ns = measure(n, [&]() { load_source(); }, [&]() {
+                for (i = m_vec.num_items; i-- > 0; )
+                {
+                    if (erase_pred<N>(i, vec2_get_at(&m_vec, i)))
+                        vec2_erase(&m_vec, i);
+                }
+            });
+            report(op, "vec2_one", N, n, ns, N);
+        }
+
+        ns = measure(n, [&]() { load_source(); }, [&]() {
+            vec2_erase_if(&m_vec, erase_pred<N>);
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(n, [&]() { load_source(); }, [&]() {
+            m_vector.erase(std::remove_if(m_vector.begin(), m_vector.end(),
+                [](const T& t) { return erase_pred<N>(0, &t); }),
+                m_vector.end());
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_find()
+    {
+        const char *op = "find";
+        size_t i, j, n = m_count, k = find_ops();
+        double ns;
+        if (!is_enabled(op))
+            return;
+        load_source();
+
+        /* searching the missing item scans all the items */
+        ns = measure(k * n, nothing, [&]() {
+            const T *a = &m_array[0];
+            for (i = 0; i < k; ++i)
+            {
+                for (j = 0; j < n; ++j)
+                {
+                    if (item_compare<N>(&m_missing, &a[j]) == 0)
+                        break;
+                }
+                s_sink += j;
+            }
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(k * n, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += (size_t)vec2_find(&m_vec, &m_missing,
+                                            item_compare<N>);
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(k * n, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += vec2_find_key(&m_vec, 0, &m_missing, 0,
+                                        (N < 8) ? N : 8);
+        });
+        report(op, "vec2_key", N, n, ns, N);
+
+        ns = measure(k * n, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += (size_t)(std::find(m_vector.begin(), m_vector.end(),
+                                             m_missing) - m_vector.begin());
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_bsearch()
+    {
+        const char *op = "bsearch";
+        size_t i, n = m_count, k = s_bsearch_count;
+        std::vector<size_t> keys(k);
+        double ns;
+        if (!is_enabled(op))
+            return;
+        load_sorted();
+        for (i = 0; i < k; ++i)
+            keys[i] = random_value() % n;
+
+        ns = measure(k, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += (size_t)bsearch(&m_sorted[keys[i]], &m_array[0],
+                                          n, N, item_compare<N>);
+        });
+        report(op, "array", N, n, ns, N);
+
+#ifndef MISRA_C
+        ns = measure(k, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += (size_t)vec2_bsearch(&m_vec, &m_sorted[keys[i]],
+                                               item_compare<N>);
+        });
+        report(op, "vec2", N, n, ns, N);
+#endif
+
+        ns = measure(k, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += vec2_lower_bound(&m_vec, &m_sorted[keys[i]],
+                                           item_compare<N>);
+        });
+        report(op, "vec2_lb", N, n, ns, N);
+
+        ns = measure(k, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += vec2_lower_bound_key(&m_vec, &m_sorted[keys[i]], 0,
+                                               (N < 8) ? N : 8,
+                                               VEC2_KEY_BYTES);
+        });
+        report(op, "vec2_key", N, n, ns, N);
+
+        ns = measure(k, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += inl_lower_bound<N>((const T *)m_vec.items, n,
+                                             &m_sorted[keys[i]]);
+        });
+        report(op, "vec2_inl", N, n, ns, N);
+
+        /* the Eytzinger copy, aligned to a cache line */
+        std::vector<T> eytz_block(n + 1 + 64);
+        T *eytz_items = &eytz_block[0];
+        while (N < 64 && ((size_t)eytz_items % 64) != 0)
+            ++eytz_items;
+        VEC2 eytz;
+        vec2_construct(&eytz, N, n + 1, eytz_items, 0);
+        vec2_eytz_build(&eytz, &m_vec);
+        ns = measure(k, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += vec2_eytz_lower_bound(&eytz, &m_sorted[keys[i]],
+                                                item_compare<N>);
+        });
+        report(op, "vec2_eyt", N, n, ns, N);
+
+        /* the hash index of the key at 7/8 load at most */
+        if (n <= s_max_sort_items)
+        {
+            size_t num_slots = VEC2_HASH_GROUP;
+            while (num_slots - num_slots / 8 < n)
+                num_slots *= 2;
+            std::vector<size_t> hash_block(
+                VEC2_HASH_BLOCK_SIZE(num_slots) / sizeof(size_t) + 1);
+            VEC2_HASHINDEX index;
+            vec2_hash_construct(&index, &hash_block[0],
+                                hash_block.size() * sizeof(size_t), 0,
+                                (N < 8) ? N : 8);
+            vec2_hash_rebuild(&index, &m_vec);
+            ns = measure(k, nothing, [&]() {
+                for (i = 0; i < k; ++i)
+                    s_sink += vec2_hash_find(&index, &m_vec,
+                                             &m_sorted[keys[i]]);
+            });
+            report(op, "vec2_hsh", N, n, ns, N);
+        }
+
+        ns = measure(k, nothing, [&]() {
+            for (i = 0; i < k; ++i)
+                s_sink += (size_t)(std::lower_bound(m_vector.begin(),
+                                                    m_vector.end(),
+                                                    m_sorted[keys[i]],
+                                                    key_less<N>) -
+                                   m_vector.begin());
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_sort()
+    {
+        const char *op = "sort";
+        size_t n = m_count;
+        double ns;
+        if (!is_enabled(op) || n > s_max_sort_items)
+            return;
+
+        ns = measure(n, [&]() { load_source(); }, [&]() {
+            qsort(&m_array[0], n, N, item_compare<N>);
+        });
+        report(op, "array", N, n, ns, N);
+
+#ifndef MISRA_C
+        ns = measure(n, [&]() { load_source(); }, [&]() {
+            vec2_sort(&m_vec, item_compare<N>);
+        });
+        report(op, "vec2", N, n, ns, N);
+#endif
+
+        ns = measure(n, [&]() { load_source(); }, [&]() {
+            vec2_sort_by_key(&m_vec, 0, (N < 8) ? N : 8, VEC2_KEY_BYTES,
+                             &m_vec2);
+        });
+        report(op, "vec2_key", N, n, ns, N);
+
+        ns = measure(n, [&]() { load_source(); }, [&]() {
+            pdq_sort<N>(&m_vec);
+        });
+        report(op, "vec2_pdq", N, n, ns, N);
+
+        ns = measure(n, [&]() { load_source(); }, [&]() {
+            vec2_stable_sort(&m_vec, item_compare<N>, &m_vec2);
+        });
+        report(op, "vec2_stb", N, n, ns, N);
+
+        ns = measure(n, [&]() { load_source(); }, [&]() {
+            vec2_sort_parallel(&m_vec, item_compare<N>, &m_vec2, 0);
+        });
+        report(op, "vec2_par", N, n, ns, N);
+
+        ns = measure(n, [&]() { load_source(); }, [&]() {
+            std::sort(m_vector.begin(), m_vector.end(), key_less<N>);
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_merge()
+    {
+        const char *op = "merge";
+        size_t n = m_count, mid = m_count / 2;
+        std::vector<T> halves(m_source);
+        VEC2 a, b;
+        double ns;
+        if (!is_enabled(op) || n > s_max_sort_items)
+            return;
+
+        std::sort(halves.begin(), halves.begin() + mid, key_less<N>);
+        std::sort(halves.begin() + mid, halves.end(), key_less<N>);
+        vec2_construct(&a, N, mid, &halves[0], mid);
+        vec2_construct(&b, N, n - mid, &halves[mid], n - mid);
+        auto load_halves = [&]() {
+            memcpy(&m_block[0], &halves[0], n * N);
+            m_vec.num_items = n;
+        };
+
+        ns = measure(n, nothing, [&]() {
+            std::merge(halves.begin(), halves.begin() + mid,
+                       halves.begin() + mid, halves.end(), &m_array[0],
+                       key_less<N>);
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            vec2_merge(&m_vec2, &a, &b, item_compare<N>);
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(n, load_halves, [&]() {
+            vec2_inplace_merge(&m_vec, mid, item_compare<N>, &m_vec2);
+        });
+        report(op, "vec2_inp", N, n, ns, N);
+
+#ifndef MISRA_C
+        /* the old way: concatenate and sort */
+        ns = measure(n, load_halves, [&]() {
+            vec2_sort(&m_vec, item_compare<N>);
+        });
+        report(op, "vec2_srt", N, n, ns, N);
+#endif
+
+        ns = measure(n, nothing, [&]() {
+            m_vector.resize(n);
+            std::merge(halves.begin(), halves.begin() + mid,
+                       halves.begin() + mid, halves.end(), m_vector.begin(),
+                       key_less<N>);
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_copy()
+    {
+        const char *op = "copy";
+        size_t n = m_count;
+        double ns;
+        if (!is_enabled(op))
+            return;
+        load_source();
+
+        ns = measure(n, nothing, [&]() {
+            memcpy(&m_array2[0], &m_array[0], n * N);
+            s_sink += m_array2[n - 1].bytes[0];
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            vec2_copy(&m_vec2, &m_vec);
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            m_vector2 = m_vector;
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_resize()
+    {
+        const char *op = "resize";
+        size_t i, n = m_count;
+        double ns;
+        if (!is_enabled(op))
+            return;
+
+        ns = measure(n, nothing, [&]() {
+            T *a = &m_array[0];
+            for (i = 0; i < n; ++i)
+                a[i] = m_item;
+            s_sink += a[n - 1].bytes[0];
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, [&]() { vec2_clear(&m_vec); }, [&]() {
+            vec2_resize(&m_vec, n, &m_item);
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(n, [&]() { m_vector.clear(); }, [&]() {
+            m_vector.resize(n, m_item);
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    void bench_assign()
+    {
+        const char *op = "assign";
+        size_t i, n = m_count;
+        double ns;
+        if (!is_enabled(op))
+            return;
+        load_source();
+
+        ns = measure(n, nothing, [&]() {
+            T *a = &m_array[0];
+            for (i = 0; i < n; ++i)
+                a[i] = m_item;
+            s_sink += a[n - 1].bytes[0];
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            vec2_assign(&m_vec, n, &m_item, N);
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            m_vector.assign(n, m_item);
+        });
+        report(op, "vector", N, n, ns, N);
+    }
+
+    /* loading a table from a file in the page cache, and reading it */
+    void bench_load()
+    {
+        const char *op = "load";
+        const char *raw_path = "vec2_bench.raw", *map_path = "vec2_bench.map";
+        size_t i, n = m_count, sum;
+        double ns;
+        FILE *fp;
+        VEC2_MAPPED mapped;
+        if (!is_enabled(op))
+            return;
+
+        fp = fopen(raw_path, "wb");
+        if (fp == NULL)
+            return;
+        fwrite(&m_source[0], N, n, fp);
+        fclose(fp);
+        remove(map_path);
+        if (!vec2_open_mapped(&mapped, map_path, N, n, VEC2_MAP_CREATE))
+        {
+            remove(raw_path);
+            return;
+        }
+        vec2_append(&mapped.vec, &m_source[0], n);
+        vec2_close_mapped(&mapped);
+
+        ns = measure(n, nothing, [&]() {
+            fp = fopen(raw_path, "rb");
+            s_sink += fread(&m_array[0], N, n, fp);
+            fclose(fp);
+            for (sum = 0, i = 0; i < n; ++i)
+                sum += m_array[i].bytes[N - 1];
+            s_sink += sum;
+        });
+        report(op, "array", N, n, ns, N);
+
+        ns = measure(n, [&]() { vec2_clear(&m_vec); }, [&]() {
+            T item;
+            fp = fopen(raw_path, "rb");
+            while (fread(&item, N, 1, fp) == 1)
+                vec2_push_back(&m_vec, &item);
+            fclose(fp);
+            for (sum = 0, i = 0; i < n; ++i)
+                sum += ((const T *)vec2_get_at(&m_vec, i))->bytes[N - 1];
+            s_sink += sum;
+        });
+        report(op, "vec2_rec", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            vec2_open_mapped(&mapped, map_path, N, 0, VEC2_MAP_READONLY);
+            for (sum = 0, i = 0; i < n; ++i)
+                sum += ((const T *)vec2_get_at(&mapped.vec, i))->bytes[N - 1];
+            s_sink += sum;
+            vec2_close_mapped(&mapped);
+        });
+        report(op, "vec2_map", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            vec2_open_mapped(&mapped, map_path, N, 0,
+                             VEC2_MAP_READONLY | VEC2_MAP_POPULATE);
+            for (sum = 0, i = 0; i < n; ++i)
+                sum += ((const T *)vec2_get_at(&mapped.vec, i))->bytes[N - 1];
+            s_sink += sum;
+            vec2_close_mapped(&mapped);
+        });
+        report(op, "vec2_pop", N, n, ns, N);
+
+        remove(raw_path);
+        remove(map_path);
+    }
+
+    /* writing the items to a file and reading them back */
+    void bench_stream()
+    {
+        const char *op = "stream";
+        const char *path = "vec2_bench.str";
+        size_t n = m_count;
+        double ns;
+        FILE *fp;
+        int fd;
+        if (!is_enabled(op))
+            return;
+        load_source();
+
+        ns = measure(n, [&]() { vec2_clear(&m_vec2); }, [&]() {
+            T item;
+            size_t i;
+            fp = fopen(path, "wb");
+            for (i = 0; i < n; ++i)
+                fwrite(vec2_get_at(&m_vec, i), N, 1, fp);
+            fclose(fp);
+            fp = fopen(path, "rb");
+            while (fread(&item, N, 1, fp) == 1)
+                vec2_push_back(&m_vec2, &item);
+            fclose(fp);
+        });
+        report(op, "vec2_rec", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+            vec2_write_fd(fd, &m_vec, 0);
+            lseek(fd, 0, SEEK_SET);
+            vec2_read_fd(fd, &m_vec2);
+            close(fd);
+        });
+        report(op, "vec2_io", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+            vec2_write_fd(fd, &m_vec, VEC2_IO_CRC32C);
+            lseek(fd, 0, SEEK_SET);
+            vec2_read_fd(fd, &m_vec2);
+            close(fd);
+        });
+        report(op, "vec2_crc", N, n, ns, N);
+
+        remove(path);
+    }
+
+    void bench_column()
+    {
+        const char *op = "column";
+        size_t i, n = m_count, sum;
+        unsigned int value;
+        double ns;
+        if (!is_enabled(op) || N < 8)
+            return;
+        load_source();
+
+        /* the first 4 bytes of the items are a column of their own */
+        std::vector<unsigned int> keys(n + 1);
+        std::vector<unsigned char> rests((n + 1) * (N - 4));
+        void *columns[2] = { &keys[0], &rests[0] };
+        size_t sizes[2] = { 4, N - 4 };
+        VEC2_SOA soa;
+        vec2_soa_construct(&soa, n, 2, columns, sizes, n);
+        for (i = 0; i < n; ++i)
+        {
+            memcpy(&keys[i], m_source[i].bytes, 4);
+            memcpy(&rests[i * (N - 4)], &m_source[i].bytes[4], N - 4);
+        }
+
+        /* sums a 4-byte field of each record */
+        ns = measure(n, nothing, [&]() {
+            const T *a = (const T *)vec2_data(&m_vec);
+            for (sum = 0, i = 0; i < n; ++i)
+            {
+                memcpy(&value, a[i].bytes, 4);
+                sum += value;
+            }
+            s_sink += sum;
+        });
+        report(op, "vec2", N, n, ns, N);
+
+        ns = measure(n, nothing, [&]() {
+            const unsigned int *a =
+                (const unsigned int *)vec2_soa_column(&soa, 0);
+            for (sum = 0, i = 0; i < n; ++i)
+                sum += a[i];
+            s_sink += sum;
+        });
+        report(op, "vec2_soa", N, n, ns, N);
+    }
+};
+
+template <size_t N>
+static void bench_item_size(void)
+{
+    size_t i, count;
+    for (i = 0; i < sizeof(s_block_bytes) / sizeof(s_block_bytes[0]); ++i)
+    {
+        if (s_block_bytes[i] > s_max_bytes)
+            break;
+        count = s_block_bytes[i] / N;
+        Bench<N> bench(count);
+        bench.run();
+    }
+}
+
+/****************************************************************************/
+
+int main(int argc, char **argv)
+{
+    size_t i;
+
+    if (argc >= 2)
+    {
+        s_max_bytes = (size_t)strtoul(argv[1], NULL, 0);
+        if (strchr(argv[1], 'K') || strchr(argv[1], 'k'))
+            s_max_bytes *= 1024;
+        if (strchr(argv[1], 'M') || strchr(argv[1], 'm'))
+            s_max_bytes *= 1024 * 1024;
+    }
+    if (argc >= 3)
+    {
+        s_operation = argv[2];
+    }
+
+#ifdef VEC2_QUICK_BUT_RISKY
+    printf("# vec2 benchmark (VEC2_QUICK_BUT_RISKY build)\n");
+#else
+    printf("# vec2 benchmark (default build)\n");
+#endif
+#ifndef NDEBUG
+    printf("# WARNING: NDEBUG is not defined. Asserts are enabled.\n");
+#endif
+    printf("%-12s %-8s %5s %10s %12s %12s\n",
+           "operation", "impl", "size", "count", "ns/op", "MB/s");
+
+    for (i = 0; i < sizeof(s_item_sizes) / sizeof(s_item_sizes[0]); ++i)
+    {
+        switch (s_item_sizes[i])
+        {
+        case 1:   bench_item_size<1>();   break;
+        case 4:   bench_item_size<4>();   break;
+        case 8:   bench_item_size<8>();   break;
+        case 16:  bench_item_size<16>();  break;
+        case 64:  bench_item_size<64>();  break;
+        case 256: bench_item_size<256>(); break;
+        default:  break;
+        }
+    }
+
+    return (s_sink == 1) ? 1 : 0;
+} /* main */
+
+/****************************************************************************/
@@ -0,0 +1,319 @@
+/****************************************************************************/
+/* vec2_gap.c --- gap buffer of vec2                                        */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_GAP_C
+#define KATAHIROMZ_VEC2_GAP_C
+
+#include "vec2_gap.h"
+
+/****************************************************************************/
+/* status checking */
+
+#ifndef vec2_status_bad
+    #define vec2_status_bad(pv)    assert(0)
+#endif
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* functions */
+
+VEC2_API bool vec2_gap_valid(const VEC2_GAP *pg)
+{
+    bool ret;
+
+    if ((pg == NULL) || (pg->num_items > pg->capacity))
+    {
+        ret = false;
+    }
+    else if (pg->gap_start > pg->num_items)
+    {
+        ret = false;
+    }
+    else if ((pg->capacity != 0U) && (pg->items == NULL))
+    {
+        ret = false;
+    }
+    else if (pg->size_per_item == 0U)
+    {
+        ret = false;
+    }
+    else
+    {
+        ret = true;
+    }
+
+    return ret;
+} /* vec2_gap_valid */
+
+#ifndef NDEBUG
+    VEC2_API void *vec2_gap_item(PVEC2_GAP pg, size_t index0)
+    {
+        char *p;
+        assert(vec2_gap_valid(pg));
+        assert(index0 < vec2_gap_size(pg));
+        p = (char *)pg->items;
+        return (void *)(p + vec2_gap_pos(pg, index0) * pg->size_per_item);
+    } /* vec2_gap_item */
+#endif  /* ndef NDEBUG */
+
+VEC2_API vec2_bool
+vec2_gap_construct(PVEC2_GAP pg, size_t size_per_item,
+                   size_t capacity, void *items, size_t num_items)
+{
+    VEC2_STATUS_INIT(ret, true);
+    assert(items != NULL);
+
+    /* NOTE: vec2 doesn't allocate memory. Just weakly refers. */
+    pg->items = items;
+    pg->size_per_item = size_per_item;
+    pg->num_items = num_items;
+    pg->capacity = capacity;
+    pg->gap_start = num_items;
+
+    assert(vec2_gap_valid(pg));
+
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_gap_construct */
+
+VEC2_API void vec2_gap_clear(PVEC2_GAP pg)
+{
+    assert(vec2_gap_valid(pg));
+    pg->num_items = 0;
+    pg->gap_start = 0;
+} /* vec2_gap_clear */
+
+VEC2_API void vec2_gap_set_cursor(PVEC2_GAP pg, size_t index0)
+{
+    char *ptr;
+    size_t gap, size_per_item;
+
+    assert(vec2_gap_valid(pg));
+    assert(index0 <= vec2_gap_size(pg));
+
+    ptr = (char *)pg->items;
+    gap = pg->capacity - pg->num_items;
+    size_per_item = pg->size_per_item;
+    if (index0 < pg->gap_start)
+    {
+        /* the items in [index0, gap_start) go after the gap */
+        memmove(&ptr[(index0 + gap) * size_per_item],
+                &ptr[index0 * size_per_item],
+                (pg->gap_start - index0) * size_per_item);
+    }
+    else if (index0 > pg->gap_start)
+    {
+        /* the items in [gap_start, index0) go before the gap */
+        memmove(&ptr[pg->gap_start * size_per_item],
+                &ptr[(pg->gap_start + gap) * size_per_item],
+                (index0 - pg->gap_start) * size_per_item);
+    }
+    pg->gap_start = index0;
+
+    assert(vec2_gap_valid(pg));
+} /* vec2_gap_set_cursor */
+
+VEC2_API vec2_bool
+vec2_gap_insert(PVEC2_GAP pg, size_t index0, size_t count,
+                const void *pitem)
+{
+    char *ptr;
+    size_t filled;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_gap_valid(pg));
+    assert(index0 <= vec2_gap_size(pg));
+    assert((pitem != NULL) || (count == 0U));
+
+    if (count <= pg->capacity - pg->num_items)
+    {
+        vec2_gap_set_cursor(pg, index0);
+        if (count > 0U)
+        {
+            /* fill by doubling the copied items */
+            ptr = (char *)pg->items + index0 * pg->size_per_item;
+            memcpy(ptr, pitem, pg->size_per_item);
+            for (filled = 1; filled < count; filled *= 2U)
+            {
+                memcpy(&ptr[filled * pg->size_per_item], ptr,
+                       ((count - filled < filled) ? count - filled : filled) *
+                       pg->size_per_item);
+            }
+        }
+        pg->gap_start += count;
+        pg->num_items += count;
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(pg);
+    }
+
+    assert(vec2_gap_valid(pg));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_gap_insert */
+
+VEC2_API vec2_bool
+vec2_gap_insert_sub(PVEC2_GAP pg, size_t index0, const VEC2 *psubvec)
+{
+    char *ptr;
+    size_t count;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_gap_valid(pg));
+    assert(vec2_valid(psubvec));
+    assert(psubvec->size_per_item == pg->size_per_item);
+    assert(index0 <= vec2_gap_size(pg));
+
+    count = vec2_size(psubvec);
+    if (count <= pg->capacity - pg->num_items)
+    {
+        vec2_gap_set_cursor(pg, index0);
+        ptr = (char *)pg->items;
+        memcpy(&ptr[index0 * pg->size_per_item], psubvec->items,
+               count * pg->size_per_item);
+        pg->gap_start += count;
+        pg->num_items += count;
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(pg);
+    }
+
+    assert(vec2_gap_valid(pg));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_gap_insert_sub */
+
+VEC2_API vec2_bool vec2_gap_erase(PVEC2_GAP pg, size_t index0)
+{
+#ifdef VEC2_QUICK_BUT_RISKY
+    vec2_gap_erase_range(pg, index0, 1);
+#else
+    return vec2_gap_erase_range(pg, index0, 1);
+#endif
+} /* vec2_gap_erase */
+
+VEC2_API vec2_bool
+vec2_gap_erase_range(PVEC2_GAP pg, size_t index0, size_t count)
+{
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_gap_valid(pg));
+    assert(index0 + count <= vec2_gap_size(pg));
+
+    if (index0 + count <= pg->num_items)
+    {
+        /* the erased items join the gap */
+        vec2_gap_set_cursor(pg, index0);
+        pg->num_items -= count;
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(pg);
+    }
+
+    assert(vec2_gap_valid(pg));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_gap_erase_range */
+
+VEC2_API void vec2_gap_compact(PVEC2_GAP pg, PVEC2 pv)
+{
+    assert(vec2_gap_valid(pg));
+    assert(pv != NULL);
+
+    vec2_gap_set_cursor(pg, pg->num_items);
+    vec2_construct(pv, pg->size_per_item, pg->num_items, pg->items,
+                   pg->num_items);
+} /* vec2_gap_compact */
+
+VEC2_API void
+vec2_gap_two_spans(PVEC2_GAP pg, void **pfirst, size_t *pcount1,
+                   void **psecond, size_t *pcount2)
+{
+    char *ptr;
+
+    assert(vec2_gap_valid(pg));
+    assert(pfirst != NULL);
+    assert(pcount1 != NULL);
+    assert(psecond != NULL);
+    assert(pcount2 != NULL);
+
+    ptr = (char *)pg->items;
+    *pfirst = ptr;
+    *pcount1 = pg->gap_start;
+    *psecond = &ptr[(pg->gap_start + pg->capacity - pg->num_items) *
+                    pg->size_per_item];
+    *pcount2 = pg->num_items - pg->gap_start;
+} /* vec2_gap_two_spans */
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* testing */
+
+/* #define VEC2_GAP_TEST */
+
+#ifdef VEC2_GAP_TEST
+    #include <stdio.h>
+
+    int main(void)
+    {
+        static char items[16], capital[] = "H";
+        VEC2_GAP gap;
+        VEC2 view, sub;
+        void *first, *second;
+        size_t count1, count2;
+        char c;
+
+        memcpy(items, "helloworld", 10);
+        vec2_gap_construct(&gap, 1, 16, items, 10);
+
+        /* edits near one position */
+        c = ',';
+        vec2_gap_insert(&gap, 5, 1, &c);
+        c = ' ';
+        vec2_gap_insert(&gap, 6, 1, &c);
+        assert(gap.gap_start == 7);
+        assert(*(char *)vec2_gap_item(&gap, 7) == 'w');
+        vec2_gap_two_spans(&gap, &first, &count1, &second, &count2);
+        assert(count1 == 7 && count2 == 5);
+        assert(memcmp(first, "hello, ", 7) == 0);
+        assert(memcmp(second, "world", 5) == 0);
+
+        vec2_gap_erase(&gap, 0);
+        vec2_construct(&sub, 1, 1, capital, 1);
+        vec2_gap_insert_sub(&gap, 0, &sub);
+        c = '!';
+        vec2_gap_insert(&gap, 12, 3, &c);
+        vec2_gap_erase_range(&gap, 13, 2);
+        assert(vec2_gap_size(&gap) == 13);
+
+        vec2_gap_compact(&gap, &view);
+        assert(vec2_size(&view) == 13);
+        assert(memcmp(vec2_data(&view), "Hello, world!", 13) == 0);
+
+        printf("vec2_gap: ok\n");
+        return 0;
+    } /* main */
+#endif  /* def VEC2_GAP_TEST */
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_GAP_C */
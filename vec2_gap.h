@@ -0,0 +1,115 @@
+/****************************************************************************/
+/* vec2_gap.h --- gap buffer of vec2                                        */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_GAP_H
+#define KATAHIROMZ_VEC2_GAP_H
+
+#include "vec2.h"
+
+/****************************************************************************/
+/* types */
+
+/*
+ * VEC2_GAP is a vec2 with the free items as a gap at the edit cursor. The
+ * items before the cursor are at the start of the fixed block, and the
+ * others are at the end. Inserting and erasing at the cursor moves no
+ * items; moving the cursor moves the items between the old and new ones.
+ */
+typedef struct VEC2_GAP
+{
+    void *  items;          /* Not malloc'ed. It's a fixed block. */
+    size_t  num_items;      /* number of items alive */
+    size_t  capacity;       /* number of items allocated */
+    size_t  size_per_item;  /* the size of one item */
+    size_t  gap_start;      /* the index of the cursor */
+} VEC2_GAP, *PVEC2_GAP;
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* functions */
+
+/* NOTE: The first num_items items of the block are the initial items.
+ *       The cursor is at the end. */
+VEC2_API vec2_bool
+vec2_gap_construct(PVEC2_GAP pg, size_t size_per_item,
+                   size_t capacity, void *items, size_t num_items);
+VEC2_API void vec2_gap_clear(PVEC2_GAP pg);
+
+/* NOTE: vec2_gap_set_cursor() moves the gap to index0. The functions below
+ *       move it to the position of the edit. */
+VEC2_API void vec2_gap_set_cursor(PVEC2_GAP pg, size_t index0);
+
+VEC2_API vec2_bool
+vec2_gap_insert(PVEC2_GAP pg, size_t index0, size_t count,
+                const void *pitem);
+VEC2_API vec2_bool
+vec2_gap_insert_sub(PVEC2_GAP pg, size_t index0, const VEC2 *psubvec);
+VEC2_API vec2_bool vec2_gap_erase(PVEC2_GAP pg, size_t index0);
+VEC2_API vec2_bool
+vec2_gap_erase_range(PVEC2_GAP pg, size_t index0, size_t count);
+
+/*
+ * NOTE: vec2_gap_compact() moves the gap to the end and stores a vec2 of
+ *       the contiguous items to pv. The view is valid until the next edit.
+ *       vec2_gap_two_spans() stores the items before and after the gap
+ *       without moving them.
+ */
+VEC2_API void vec2_gap_compact(PVEC2_GAP pg, PVEC2 pv);
+VEC2_API void
+vec2_gap_two_spans(PVEC2_GAP pg, void **pfirst, size_t *pcount1,
+                   void **psecond, size_t *pcount2);
+
+/* validation for debugging */
+VEC2_API bool vec2_gap_valid(const VEC2_GAP *pg);
+
+#ifndef NDEBUG
+    VEC2_API void *vec2_gap_item(PVEC2_GAP pg, size_t index0);
+#endif
+
+/****************************************************************************/
+/* function macros */
+
+#define vec2_gap_empty(pg)          ((pg)->num_items == 0)
+#define vec2_gap_size(pg)           ((pg)->num_items)
+#define vec2_gap_capacity(pg)       (*(const size_t *)&(pg)->capacity)
+
+/* NOTE: vec2_gap_pos() is the position of index0 in the block. */
+#define vec2_gap_pos(pg,index0) ( \
+    ((index0) < (pg)->gap_start) ? (index0) : \
+    (index0) + (pg)->capacity - (pg)->num_items \
+)
+
+#ifdef NDEBUG
+    #define vec2_gap_item(pg,index0) ( \
+        (void *)( \
+            ((char *)(pg)->items) + \
+            vec2_gap_pos((pg), (index0)) * (pg)->size_per_item \
+        ) \
+    )
+#endif
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* header-only build */
+
+#ifdef VEC2_INLINE
+    #include "vec2_gap.c"
+#endif
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_GAP_H */
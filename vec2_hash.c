@@ -0,0 +1,524 @@
+/****************************************************************************/
+/* vec2_hash.c --- hash index of vec2                                       */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_HASH_C
+#define KATAHIROMZ_VEC2_HASH_C
+
+#include "vec2_hash.h"
+
+/****************************************************************************/
+/* status checking */
+
+#ifndef vec2_status_bad
+    #define vec2_status_bad(pv)    assert(0)
+#endif
+
+#ifdef VEC2_USE_SSE2
+    #include <emmintrin.h>
+#endif
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* tags */
+
+/*
+ * NOTE: The tag of a used slot is the low 7 bits of the hash. The tags of
+ *       the first VEC2_HASH_GROUP slots are mirrored after the last slot, so
+ *       that a group can be loaded at any slot.
+ */
+#define VEC2_HASH_EMPTY     0x80
+#define VEC2_HASH_DELETED   0xFE
+
+/* the odd multiplier of the golden ratio */
+#define VEC2_HASH_MUL \
+    ((sizeof(size_t) > 4U) ? \
+     (((size_t)0x9E3779B9UL << 16 << 16) | 0x7F4A7C15UL) : \
+     (size_t)0x9E3779B1UL)
+
+/* hashes the key of key_size bytes */
+VEC2_INLINE_FN size_t vec2_hash_bytes(const void *key, size_t key_size)
+{
+    const unsigned char *p = (const unsigned char *)key;
+    size_t h = key_size, w;
+
+    while (key_size >= sizeof(size_t))
+    {
+        memcpy(&w, p, sizeof(size_t));
+        h = (h ^ w) * VEC2_HASH_MUL;
+        h ^= h >> (sizeof(size_t) * 4U);
+        p += sizeof(size_t);
+        key_size -= sizeof(size_t);
+    }
+    if (key_size > 0U)
+    {
+        w = 0;
+        memcpy(&w, p, key_size);
+        h = (h ^ w) * VEC2_HASH_MUL;
+    }
+    h *= VEC2_HASH_MUL;
+    return h ^ (h >> (sizeof(size_t) * 4U));
+} /* vec2_hash_bytes */
+
+/* returns the position of the lowest set bit. mask must not be zero. */
+VEC2_INLINE_FN unsigned int vec2_hash_bit_scan(unsigned int mask)
+{
+#ifdef __GNUC__
+    return (unsigned int)__builtin_ctz(mask);
+#else
+    unsigned int n = 0;
+    while ((mask & 1U) == 0U)
+    {
+        mask >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+} /* vec2_hash_bit_scan */
+
+/* the bit mask of the tags in the group that equal to tag */
+VEC2_INLINE_FN unsigned int
+vec2_hash_match(const unsigned char *group, unsigned char tag)
+{
+#ifdef VEC2_USE_SSE2
+    __m128i g = _mm_loadu_si128((const __m128i *)group);
+    return (unsigned int)_mm_movemask_epi8(
+        _mm_cmpeq_epi8(g, _mm_set1_epi8((char)tag)));
+#else
+    unsigned int i, mask = 0;
+    for (i = 0; i < VEC2_HASH_GROUP; ++i)
+    {
+        if (group[i] == tag)
+        {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+#endif
+} /* vec2_hash_match */
+
+/* the bit mask of the empty or deleted tags in the group */
+VEC2_INLINE_FN unsigned int vec2_hash_match_free(const unsigned char *group)
+{
+#ifdef VEC2_USE_SSE2
+    return (unsigned int)_mm_movemask_epi8(
+        _mm_loadu_si128((const __m128i *)group));
+#else
+    unsigned int i, mask = 0;
+    for (i = 0; i < VEC2_HASH_GROUP; ++i)
+    {
+        if (group[i] & 0x80)
+        {
+            mask |= 1U << i;
+        }
+    }
+    return mask;
+#endif
+} /* vec2_hash_match_free */
+
+VEC2_INLINE_FN void
+vec2_hash_set_tag(VEC2_HASHINDEX *ph, size_t i, unsigned char tag)
+{
+    ph->tags[i] = tag;
+    if (i < VEC2_HASH_GROUP)
+    {
+        ph->tags[ph->num_slots + i] = tag;
+    }
+} /* vec2_hash_set_tag */
+
+/* the number of the slots that the index can hold */
+VEC2_INLINE_FN size_t vec2_hash_limit(const VEC2_HASHINDEX *ph)
+{
+    return ph->num_slots - ph->num_slots / 8U;
+} /* vec2_hash_limit */
+
+VEC2_INLINE_FN const char *
+vec2_hash_key(const VEC2_HASHINDEX *ph, const VEC2 *pv, size_t index0)
+{
+    return (const char *)pv->items + index0 * pv->size_per_item +
+           ph->key_offset;
+} /* vec2_hash_key */
+
+/****************************************************************************/
+/* probing */
+
+/*
+ * NOTE: The groups are probed at the triangular numbers of VEC2_HASH_GROUP
+ *       slots, which visit all the groups because the number of the slots is
+ *       a power of two. A group with an empty slot ends the probing.
+ */
+
+/* the slot of the item of index0 whose key is key, or VEC2_NPOS */
+VEC2_INLINE_FN size_t
+vec2_hash_locate(const VEC2_HASHINDEX *ph, const void *key, size_t index0)
+{
+    size_t h = vec2_hash_bytes(key, ph->key_size);
+    size_t mask = ph->num_slots - 1, pos = (h >> 7) & mask, step = 0, i;
+    unsigned char tag = (unsigned char)(h & 0x7F);
+    unsigned int m;
+
+    for (;;)
+    {
+        m = vec2_hash_match(&ph->tags[pos], tag);
+        while (m != 0U)
+        {
+            i = (pos + vec2_hash_bit_scan(m)) & mask;
+            if (ph->slots[i] == index0)
+            {
+                return i;
+            }
+            m &= m - 1U;
+        }
+        if (vec2_hash_match(&ph->tags[pos], VEC2_HASH_EMPTY) != 0U)
+        {
+            return VEC2_NPOS;
+        }
+        step += VEC2_HASH_GROUP;
+        pos = (pos + step) & mask;
+    }
+} /* vec2_hash_locate */
+
+/* adds the item of index0. the index must have a free slot. */
+VEC2_INLINE_FN void
+vec2_hash_insert(VEC2_HASHINDEX *ph, const void *key, size_t index0)
+{
+    size_t h = vec2_hash_bytes(key, ph->key_size);
+    size_t mask = ph->num_slots - 1, pos = (h >> 7) & mask, step = 0, i;
+    unsigned int m;
+
+    for (;;)
+    {
+        m = vec2_hash_match_free(&ph->tags[pos]);
+        if (m != 0U)
+        {
+            i = (pos + vec2_hash_bit_scan(m)) & mask;
+            if (ph->tags[i] == VEC2_HASH_DELETED)
+            {
+                ph->num_deleted -= 1U;
+            }
+            vec2_hash_set_tag(ph, i, (unsigned char)(h & 0x7F));
+            ph->slots[i] = index0;
+            ph->num_used += 1U;
+            return;
+        }
+        step += VEC2_HASH_GROUP;
+        pos = (pos + step) & mask;
+    }
+} /* vec2_hash_insert */
+
+/* removes the item of index0 */
+VEC2_INLINE_FN void
+vec2_hash_remove(VEC2_HASHINDEX *ph, const void *key, size_t index0)
+{
+    size_t i = vec2_hash_locate(ph, key, index0);
+    assert(i != VEC2_NPOS);
+    vec2_hash_set_tag(ph, i, VEC2_HASH_DELETED);
+    ph->num_used -= 1U;
+    ph->num_deleted += 1U;
+} /* vec2_hash_remove */
+
+/* adds the item of index0 of pv. it rebuilds the index if the deleted
+   slots take the room. */
+VEC2_INLINE_FN void
+vec2_hash_add(VEC2_HASHINDEX *ph, const VEC2 *pv, size_t index0)
+{
+    size_t i;
+
+    if (ph->num_used + ph->num_deleted < vec2_hash_limit(ph))
+    {
+        vec2_hash_insert(ph, vec2_hash_key(ph, pv, index0), index0);
+        return;
+    }
+    vec2_hash_clear(ph);
+    for (i = 0; i < pv->num_items; ++i)
+    {
+        vec2_hash_insert(ph, vec2_hash_key(ph, pv, i), i);
+    }
+} /* vec2_hash_add */
+
+/****************************************************************************/
+/* functions */
+
+VEC2_API void
+vec2_hash_construct(VEC2_HASHINDEX *ph, void *block, size_t block_size,
+                    size_t key_offset, size_t key_size)
+{
+    size_t num_slots = VEC2_HASH_GROUP;
+
+    assert(ph != NULL);
+    assert(block != NULL);
+    assert(key_size > 0U);
+    assert(VEC2_HASH_BLOCK_SIZE(num_slots) <= block_size);
+
+    while (VEC2_HASH_BLOCK_SIZE(num_slots * 2U) <= block_size)
+    {
+        num_slots *= 2U;
+    }
+    ph->slots = (size_t *)block;
+    ph->tags = (unsigned char *)&ph->slots[num_slots];
+    ph->num_slots = num_slots;
+    ph->key_offset = key_offset;
+    ph->key_size = key_size;
+    vec2_hash_clear(ph);
+} /* vec2_hash_construct */
+
+VEC2_API void vec2_hash_clear(VEC2_HASHINDEX *ph)
+{
+    assert(ph != NULL);
+    memset(ph->tags, VEC2_HASH_EMPTY, ph->num_slots + VEC2_HASH_GROUP);
+    ph->num_used = 0;
+    ph->num_deleted = 0;
+} /* vec2_hash_clear */
+
+VEC2_API vec2_bool vec2_hash_rebuild(VEC2_HASHINDEX *ph, const VEC2 *pv)
+{
+    size_t i;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(ph != NULL);
+    assert(vec2_valid(pv));
+    assert(ph->key_offset + ph->key_size <= pv->size_per_item);
+
+    vec2_hash_clear(ph);
+    if (pv->num_items <= vec2_hash_limit(ph))
+    {
+        for (i = 0; i < pv->num_items; ++i)
+        {
+            vec2_hash_insert(ph, vec2_hash_key(ph, pv, i), i);
+        }
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(pv);
+    }
+
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_hash_rebuild */
+
+VEC2_API size_t
+vec2_hash_find(const VEC2_HASHINDEX *ph, const VEC2 *pv, const void *key)
+{
+    size_t h, mask, pos, step = 0, i;
+    unsigned char tag;
+    unsigned int m;
+
+    assert(ph != NULL);
+    assert(vec2_valid(pv));
+    assert(key != NULL);
+
+    h = vec2_hash_bytes(key, ph->key_size);
+    mask = ph->num_slots - 1;
+    pos = (h >> 7) & mask;
+    tag = (unsigned char)(h & 0x7F);
+    /* the slots of the group miss the cache together with the tags */
+    VEC2_PREFETCH(&ph->slots[pos]);
+    for (;;)
+    {
+        m = vec2_hash_match(&ph->tags[pos], tag);
+        while (m != 0U)
+        {
+            i = (pos + vec2_hash_bit_scan(m)) & mask;
+            if (memcmp(vec2_hash_key(ph, pv, ph->slots[i]), key,
+                       ph->key_size) == 0)
+            {
+                return ph->slots[i];
+            }
+            m &= m - 1U;
+        }
+        if (vec2_hash_match(&ph->tags[pos], VEC2_HASH_EMPTY) != 0U)
+        {
+            return VEC2_NPOS;
+        }
+        step += VEC2_HASH_GROUP;
+        pos = (pos + step) & mask;
+    }
+} /* vec2_hash_find */
+
+VEC2_API vec2_bool
+vec2_hash_push_back(VEC2_HASHINDEX *ph, PVEC2 pv, const void *pitem)
+{
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(ph != NULL);
+    assert(vec2_valid(pv));
+    assert(pitem != NULL);
+
+    if (pv->num_items < pv->capacity &&
+        ph->num_used < vec2_hash_limit(ph))
+    {
+        vec2_push_back(pv, pitem);
+        vec2_hash_add(ph, pv, pv->num_items - 1U);
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(pv);
+    }
+
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_hash_push_back */
+
+VEC2_API vec2_bool
+vec2_hash_set_at(VEC2_HASHINDEX *ph, PVEC2 pv, size_t index0,
+                 const void *pitem)
+{
+    assert(ph != NULL);
+    assert(vec2_valid(pv));
+    assert(index0 < pv->num_items);
+    assert(pitem != NULL);
+
+    vec2_hash_remove(ph, vec2_hash_key(ph, pv, index0), index0);
+    vec2_set_at(pv, index0, pitem);
+    vec2_hash_add(ph, pv, index0);
+    VEC2_STATUS_RETURN(true);
+} /* vec2_hash_set_at */
+
+VEC2_API vec2_bool
+vec2_hash_erase(VEC2_HASHINDEX *ph, PVEC2 pv, size_t index0)
+{
+    size_t i, j;
+
+    assert(ph != NULL);
+    assert(vec2_valid(pv));
+    assert(index0 < pv->num_items);
+
+    vec2_hash_remove(ph, vec2_hash_key(ph, pv, index0), index0);
+    for (j = index0 + 1U; j < pv->num_items; ++j)
+    {
+        i = vec2_hash_locate(ph, vec2_hash_key(ph, pv, j), j);
+        assert(i != VEC2_NPOS);
+        ph->slots[i] = j - 1U;
+    }
+    vec2_erase(pv, index0);
+    VEC2_STATUS_RETURN(true);
+} /* vec2_hash_erase */
+
+VEC2_API vec2_bool
+vec2_hash_erase_unordered(VEC2_HASHINDEX *ph, PVEC2 pv, size_t index0)
+{
+    size_t i, last;
+
+    assert(ph != NULL);
+    assert(vec2_valid(pv));
+    assert(index0 < pv->num_items);
+
+    last = pv->num_items - 1U;
+    vec2_hash_remove(ph, vec2_hash_key(ph, pv, index0), index0);
+    if (index0 != last)
+    {
+        i = vec2_hash_locate(ph, vec2_hash_key(ph, pv, last), last);
+        assert(i != VEC2_NPOS);
+        ph->slots[i] = index0;
+    }
+    vec2_erase_unordered(pv, index0);
+    VEC2_STATUS_RETURN(true);
+} /* vec2_hash_erase_unordered */
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* testing */
+
+/* #define VEC2_HASH_TEST */
+
+#ifdef VEC2_HASH_TEST
+    #include <stdio.h>
+    #include <stddef.h>
+
+    typedef struct ENTRY
+    {
+        double  value;
+        int     key;
+    } ENTRY;
+
+    #define NUM_ENTRIES     1000
+
+    static ENTRY s_entries[NUM_ENTRIES];
+    /* NOTE: size_t for the alignment of the slots */
+    static size_t s_block[(VEC2_HASH_BLOCK_SIZE(2048) + sizeof(size_t) - 1) /
+                          sizeof(size_t)];
+
+    /* checks that every item is found at its index */
+    static void check_index(const VEC2_HASHINDEX *ph, const VEC2 *pv)
+    {
+        size_t i, found;
+        const ENTRY *entry;
+        for (i = 0; i < vec2_size(pv); ++i)
+        {
+            entry = (const ENTRY *)vec2_const_item(pv, i);
+            found = vec2_hash_find(ph, pv, &entry->key);
+            assert(found == i);
+        }
+        assert(ph->num_used == vec2_size(pv));
+    }
+
+    int main(void)
+    {
+        VEC2 vec;
+        VEC2_HASHINDEX index;
+        ENTRY entry;
+        size_t i, found;
+        int key;
+
+        vec2_construct(&vec, sizeof(ENTRY), NUM_ENTRIES, s_entries, 0);
+        vec2_hash_construct(&index, s_block, sizeof(s_block),
+                            offsetof(ENTRY, key), sizeof(int));
+        assert(index.num_slots == 2048);
+
+        for (i = 0; i < NUM_ENTRIES; ++i)
+        {
+            entry.key = (int)(i * 7919);
+            entry.value = (double)i;
+            vec2_hash_push_back(&index, &vec, &entry);
+        }
+        check_index(&index, &vec);
+        key = -1;
+        found = vec2_hash_find(&index, &vec, &key);
+        assert(found == VEC2_NPOS);
+
+        /* erase and reuse the slots many times */
+        for (i = 0; i < 5000; ++i)
+        {
+            vec2_hash_erase_unordered(&index, &vec, (i * 31) % NUM_ENTRIES);
+            entry.key = (int)(NUM_ENTRIES * 7919 + i);
+            vec2_hash_push_back(&index, &vec, &entry);
+        }
+        check_index(&index, &vec);
+
+        vec2_hash_erase(&index, &vec, 10);
+        vec2_hash_erase(&index, &vec, 0);
+        check_index(&index, &vec);
+
+        entry.key = -5;
+        vec2_hash_set_at(&index, &vec, 3, &entry);
+        found = vec2_hash_find(&index, &vec, &entry.key);
+        assert(found == 3);
+        check_index(&index, &vec);
+
+        vec2_hash_rebuild(&index, &vec);
+        check_index(&index, &vec);
+        assert(index.num_deleted == 0);
+
+        printf("vec2_hash: ok\n");
+        return 0;
+    } /* main */
+#endif  /* def VEC2_HASH_TEST */
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_HASH_C */
@@ -0,0 +1,106 @@
+/****************************************************************************/
+/* vec2_hash.h --- hash index of vec2                                       */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_HASH_H
+#define KATAHIROMZ_VEC2_HASH_H
+
+#include "vec2.h"
+
+/*
+ * NOTE: A hash index maps the key of key_size bytes at key_offset in each
+ *       item of a vec2 to the index of the item. It lives in a fixed block
+ *       supplied by the caller, like vec2. The slots are probed by groups of
+ *       VEC2_HASH_GROUP one-byte tags, which are compared at once with SSE2.
+ *       The keys are compared byte by byte. Duplicate keys are allowed;
+ *       vec2_hash_find() returns one of them.
+ */
+#define VEC2_HASH_GROUP     16
+
+/*
+ * the bytes of the block for the number of the slots (a power of two)
+ * NOTE: The block starts with an array of size_t, so it must be aligned
+ *       for size_t (e.g. a size_t array or a malloc'ed block).
+ */
+#define VEC2_HASH_BLOCK_SIZE(num_slots) \
+    ((num_slots) * (sizeof(size_t) + 1) + VEC2_HASH_GROUP)
+
+/****************************************************************************/
+/* types */
+
+typedef struct VEC2_HASHINDEX
+{
+    size_t *            slots;          /* the item indexes */
+    unsigned char *     tags;           /* the control bytes of the slots */
+    size_t              num_slots;      /* a power of two */
+    size_t              num_used;       /* the slots of the items */
+    size_t              num_deleted;    /* the slots of the erased items */
+    size_t              key_offset;
+    size_t              key_size;
+} VEC2_HASHINDEX;
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* functions */
+
+/*
+ * construction
+ * NOTE: vec2_hash_construct() uses the largest power of two of the slots
+ *       that block_size bytes can hold. It needs VEC2_HASH_GROUP slots at
+ *       least. The index can hold 7/8 of the slots.
+ *       vec2_hash_rebuild() indexes all the items of pv again.
+ */
+VEC2_API void
+vec2_hash_construct(VEC2_HASHINDEX *ph, void *block, size_t block_size,
+                    size_t key_offset, size_t key_size);
+VEC2_API void vec2_hash_clear(VEC2_HASHINDEX *ph);
+VEC2_API vec2_bool vec2_hash_rebuild(VEC2_HASHINDEX *ph, const VEC2 *pv);
+
+/* NOTE: vec2_hash_find() returns the index of the item whose key equals
+ *       to the key, or VEC2_NPOS. */
+VEC2_API size_t
+vec2_hash_find(const VEC2_HASHINDEX *ph, const VEC2 *pv, const void *key);
+
+/*
+ * modification
+ * NOTE: These functions modify pv like vec2_push_back(), vec2_set_at(),
+ *       vec2_erase() and vec2_erase_unordered() and keep the index
+ *       consistent. vec2_hash_erase() updates the indexes of the items
+ *       after index0, so vec2_hash_erase_unordered() is faster.
+ *       If the vec2 or the index is full, they return false and change
+ *       nothing.
+ */
+VEC2_API vec2_bool
+vec2_hash_push_back(VEC2_HASHINDEX *ph, PVEC2 pv, const void *pitem);
+VEC2_API vec2_bool
+vec2_hash_set_at(VEC2_HASHINDEX *ph, PVEC2 pv, size_t index0,
+                 const void *pitem);
+VEC2_API vec2_bool
+vec2_hash_erase(VEC2_HASHINDEX *ph, PVEC2 pv, size_t index0);
+VEC2_API vec2_bool
+vec2_hash_erase_unordered(VEC2_HASHINDEX *ph, PVEC2 pv, size_t index0);
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* header-only build */
+
+#ifdef VEC2_INLINE
+    #include "vec2_hash.c"
+#endif
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_HASH_H */
@@ -0,0 +1,885 @@
+/****************************************************************************/
+/* vec2_io.c --- file I/O of vec2                                           */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_IO_C
+#define KATAHIROMZ_VEC2_IO_C
+
+#ifdef KATAHIROMZ_VEC2_IO_H
+    /* NOTE: vec2_io.h came first (VEC2_INLINE), so the libc headers are
+     *       already in and the feature macros below would be too late. */
+    #if !defined(_POSIX_C_SOURCE) || (_POSIX_C_SOURCE < 200809L)
+        #error vec2_io with VEC2_INLINE needs _POSIX_C_SOURCE >= 200809L \
+               (or _DEFAULT_SOURCE) defined before any #include.
+    #endif
+#else
+    #ifndef _POSIX_C_SOURCE
+        #define _POSIX_C_SOURCE 200809L
+    #endif
+    #ifndef _DEFAULT_SOURCE
+        #define _DEFAULT_SOURCE     /* for MAP_POPULATE */
+    #endif
+#endif
+
+#include "vec2_io.h"
+#include <stddef.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+
+/****************************************************************************/
+/* status checking */
+
+#ifndef vec2_status_bad
+    #define vec2_status_bad(pv)    assert(0)
+#endif
+
+#ifdef VEC2_USE_SSE42
+    #include <nmmintrin.h>
+#endif
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* mapped file */
+
+VEC2_INLINE_FN void vec2_mapped_magic(char *magic)
+{
+    memcpy(magic, "VEC2MAP", 7);
+    magic[7] = (char)sizeof(size_t);
+} /* vec2_mapped_magic */
+
+/* FNV-1a of the header fields before the checksum */
+VEC2_INLINE_FN size_t vec2_mapped_checksum(const VEC2_MAPPED_HEADER *header)
+{
+    const unsigned char *p = (const unsigned char *)header;
+    size_t i, hash = 2166136261U;
+
+    for (i = 0; i < offsetof(VEC2_MAPPED_HEADER, checksum); ++i)
+    {
+        hash = (hash ^ p[i]) * 16777619U;
+    }
+    return hash;
+} /* vec2_mapped_checksum */
+
+/* NOTE: It reads the header of an existing file, or makes a new one. Then
+ *       it grows the file to capacity if needed. */
+VEC2_INLINE_FN bool
+vec2_mapped_prepare(int fd, VEC2_MAPPED_HEADER *header, size_t size_per_item,
+                    size_t capacity, bool create, bool *pchanged)
+{
+    struct stat st;
+    char magic[8];
+    size_t file_size;
+
+    assert(sizeof(VEC2_MAPPED_HEADER) <= VEC2_MAPPED_HEADER_SIZE);
+
+    if (fstat(fd, &st) != 0)
+    {
+        return false;
+    }
+    file_size = (size_t)st.st_size;
+
+    *pchanged = false;
+    if (file_size == 0)
+    {
+        /* a new file */
+        if (!create || capacity == 0)
+        {
+            return false;
+        }
+        memset(header, 0, sizeof(*header));
+        vec2_mapped_magic(header->magic);
+        header->version = VEC2_MAPPED_VERSION;
+        header->header_size = VEC2_MAPPED_HEADER_SIZE;
+        header->size_per_item = size_per_item;
+        *pchanged = true;
+    }
+    else
+    {
+        if (file_size < VEC2_MAPPED_HEADER_SIZE ||
+            pread(fd, header, sizeof(*header), 0) != (ssize_t)sizeof(*header))
+        {
+            return false;
+        }
+
+        vec2_mapped_magic(magic);
+        if (memcmp(header->magic, magic, sizeof(magic)) != 0 ||
+            header->version != VEC2_MAPPED_VERSION ||
+            header->header_size != VEC2_MAPPED_HEADER_SIZE ||
+            header->checksum != vec2_mapped_checksum(header))
+        {
+            return false;
+        }
+        if (header->size_per_item != size_per_item ||
+            header->num_items > header->capacity ||
+            header->capacity > ((size_t)-1 - VEC2_MAPPED_HEADER_SIZE) /
+                               size_per_item ||
+            file_size < VEC2_MAPPED_HEADER_SIZE +
+                        header->capacity * size_per_item)
+        {
+            return false;
+        }
+    }
+
+    if (capacity > header->capacity)
+    {
+        if (!create ||
+            capacity > ((size_t)-1 - VEC2_MAPPED_HEADER_SIZE) / size_per_item)
+        {
+            return false;
+        }
+        /* the new items are zeros */
+        if (ftruncate(fd, (off_t)(VEC2_MAPPED_HEADER_SIZE +
+                                  capacity * size_per_item)) != 0)
+        {
+            return false;
+        }
+        header->capacity = capacity;
+        *pchanged = true;
+    }
+
+    return true;
+} /* vec2_mapped_prepare */
+
+VEC2_API bool
+vec2_open_mapped(PVEC2_MAPPED pm, const char *path, size_t size_per_item,
+                 size_t capacity, int flags)
+{
+    VEC2_MAPPED_HEADER header;
+    bool readonly, changed;
+    int fd, prot, map_flags;
+    size_t map_size;
+    void *base;
+
+    assert(pm != NULL);
+    assert(path != NULL);
+    assert(size_per_item > 0U);
+
+    readonly = ((flags & VEC2_MAP_READONLY) != 0);
+    fd = open(path, (readonly ? O_RDONLY : O_RDWR) |
+                    ((flags & VEC2_MAP_CREATE) && !readonly ? O_CREAT : 0),
+              0666);
+    if (fd == -1)
+    {
+        return false;
+    }
+    if (!vec2_mapped_prepare(fd, &header, size_per_item, capacity,
+                             (flags & VEC2_MAP_CREATE) && !readonly,
+                             &changed))
+    {
+        close(fd);
+        return false;
+    }
+
+    map_size = VEC2_MAPPED_HEADER_SIZE + header.capacity * size_per_item;
+    prot = PROT_READ | (readonly ? 0 : PROT_WRITE);
+    map_flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (flags & VEC2_MAP_POPULATE)
+    {
+        map_flags |= MAP_POPULATE;
+    }
+#endif
+    base = mmap(NULL, map_size, prot, map_flags, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    /* the hints are just hints; their errors don't matter */
+#ifndef MAP_POPULATE
+    if (flags & VEC2_MAP_POPULATE)
+    {
+        posix_madvise(base, map_size, POSIX_MADV_WILLNEED);
+    }
+#endif
+    if (flags & VEC2_MAP_SEQUENTIAL)
+    {
+        posix_madvise(base, map_size, POSIX_MADV_SEQUENTIAL);
+    }
+    if (flags & VEC2_MAP_RANDOM)
+    {
+        posix_madvise(base, map_size, POSIX_MADV_RANDOM);
+    }
+
+    if (changed)
+    {
+        header.checksum = vec2_mapped_checksum(&header);
+        memcpy(base, &header, sizeof(header));
+    }
+
+    pm->base = base;
+    pm->map_size = map_size;
+    pm->fd = fd;
+    pm->flags = flags;
+    vec2_construct(&pm->vec, size_per_item, header.capacity,
+                   (char *)base + VEC2_MAPPED_HEADER_SIZE, header.num_items);
+    return true;
+} /* vec2_open_mapped */
+
+VEC2_API bool
+vec2_sync_mapped(PVEC2_MAPPED pm, size_t index0, size_t count)
+{
+    VEC2_MAPPED_HEADER *header;
+    size_t page, first, last;
+    int mode;
+
+    assert(pm != NULL);
+    assert(pm->base != NULL);
+    assert(!(pm->flags & VEC2_MAP_READONLY));
+    assert(vec2_valid(&pm->vec));
+    assert(index0 + count <= vec2_size(&pm->vec));
+
+    mode = (pm->flags & VEC2_MAP_ASYNC) ? MS_ASYNC : MS_SYNC;
+
+    /* the items first, so the count of the header never gets ahead */
+    if (count > 0U)
+    {
+        page = (size_t)sysconf(_SC_PAGESIZE);
+        first = VEC2_MAPPED_HEADER_SIZE + index0 * pm->vec.size_per_item;
+        last = first + count * pm->vec.size_per_item;
+        first -= first % page;
+        if (msync((char *)pm->base + first, last - first, mode) != 0)
+        {
+            return false;
+        }
+    }
+
+    header = (VEC2_MAPPED_HEADER *)pm->base;
+    header->num_items = pm->vec.num_items;
+    header->checksum = vec2_mapped_checksum(header);
+    return msync(pm->base, VEC2_MAPPED_HEADER_SIZE, mode) == 0;
+} /* vec2_sync_mapped */
+
+VEC2_API bool vec2_close_mapped(PVEC2_MAPPED pm)
+{
+    bool ok = true;
+
+    assert(pm != NULL);
+    assert(pm->base != NULL);
+
+    if (!(pm->flags & VEC2_MAP_READONLY))
+    {
+        ok = vec2_sync_mapped(pm, 0, vec2_size(&pm->vec));
+    }
+    if (munmap(pm->base, pm->map_size) != 0)
+    {
+        ok = false;
+    }
+    if (close(pm->fd) != 0)
+    {
+        ok = false;
+    }
+
+    pm->base = NULL;
+    pm->map_size = 0;
+    pm->fd = -1;
+    return ok;
+} /* vec2_close_mapped */
+
+/****************************************************************************/
+/* CRC32C */
+
+/* the table of the reflected polynomial 0x82F63B78 */
+static const unsigned long vec2_crc32c_table[256] =
+{
+    0x00000000UL, 0xF26B8303UL, 0xE13B70F7UL, 0x1350F3F4UL,
+    0xC79A971FUL, 0x35F1141CUL, 0x26A1E7E8UL, 0xD4CA64EBUL,
+    0x8AD958CFUL, 0x78B2DBCCUL, 0x6BE22838UL, 0x9989AB3BUL,
+    0x4D43CFD0UL, 0xBF284CD3UL, 0xAC78BF27UL, 0x5E133C24UL,
+    0x105EC76FUL, 0xE235446CUL, 0xF165B798UL, 0x030E349BUL,
+    0xD7C45070UL, 0x25AFD373UL, 0x36FF2087UL, 0xC494A384UL,
+    0x9A879FA0UL, 0x68EC1CA3UL, 0x7BBCEF57UL, 0x89D76C54UL,
+    0x5D1D08BFUL, 0xAF768BBCUL, 0xBC267848UL, 0x4E4DFB4BUL,
+    0x20BD8EDEUL, 0xD2D60DDDUL, 0xC186FE29UL, 0x33ED7D2AUL,
+    0xE72719C1UL, 0x154C9AC2UL, 0x061C6936UL, 0xF477EA35UL,
+    0xAA64D611UL, 0x580F5512UL, 0x4B5FA6E6UL, 0xB93425E5UL,
+    0x6DFE410EUL, 0x9F95C20DUL, 0x8CC531F9UL, 0x7EAEB2FAUL,
+    0x30E349B1UL, 0xC288CAB2UL, 0xD1D83946UL, 0x23B3BA45UL,
+    0xF779DEAEUL, 0x05125DADUL, 0x1642AE59UL, 0xE4292D5AUL,
+    0xBA3A117EUL, 0x4851927DUL, 0x5B016189UL, 0xA96AE28AUL,
+    0x7DA08661UL, 0x8FCB0562UL, 0x9C9BF696UL, 0x6EF07595UL,
+    0x417B1DBCUL, 0xB3109EBFUL, 0xA0406D4BUL, 0x522BEE48UL,
+    0x86E18AA3UL, 0x748A09A0UL, 0x67DAFA54UL, 0x95B17957UL,
+    0xCBA24573UL, 0x39C9C670UL, 0x2A993584UL, 0xD8F2B687UL,
+    0x0C38D26CUL, 0xFE53516FUL, 0xED03A29BUL, 0x1F682198UL,
+    0x5125DAD3UL, 0xA34E59D0UL, 0xB01EAA24UL, 0x42752927UL,
+    0x96BF4DCCUL, 0x64D4CECFUL, 0x77843D3BUL, 0x85EFBE38UL,
+    0xDBFC821CUL, 0x2997011FUL, 0x3AC7F2EBUL, 0xC8AC71E8UL,
+    0x1C661503UL, 0xEE0D9600UL, 0xFD5D65F4UL, 0x0F36E6F7UL,
+    0x61C69362UL, 0x93AD1061UL, 0x80FDE395UL, 0x72966096UL,
+    0xA65C047DUL, 0x5437877EUL, 0x4767748AUL, 0xB50CF789UL,
+    0xEB1FCBADUL, 0x197448AEUL, 0x0A24BB5AUL, 0xF84F3859UL,
+    0x2C855CB2UL, 0xDEEEDFB1UL, 0xCDBE2C45UL, 0x3FD5AF46UL,
+    0x7198540DUL, 0x83F3D70EUL, 0x90A324FAUL, 0x62C8A7F9UL,
+    0xB602C312UL, 0x44694011UL, 0x5739B3E5UL, 0xA55230E6UL,
+    0xFB410CC2UL, 0x092A8FC1UL, 0x1A7A7C35UL, 0xE811FF36UL,
+    0x3CDB9BDDUL, 0xCEB018DEUL, 0xDDE0EB2AUL, 0x2F8B6829UL,
+    0x82F63B78UL, 0x709DB87BUL, 0x63CD4B8FUL, 0x91A6C88CUL,
+    0x456CAC67UL, 0xB7072F64UL, 0xA457DC90UL, 0x563C5F93UL,
+    0x082F63B7UL, 0xFA44E0B4UL, 0xE9141340UL, 0x1B7F9043UL,
+    0xCFB5F4A8UL, 0x3DDE77ABUL, 0x2E8E845FUL, 0xDCE5075CUL,
+    0x92A8FC17UL, 0x60C37F14UL, 0x73938CE0UL, 0x81F80FE3UL,
+    0x55326B08UL, 0xA759E80BUL, 0xB4091BFFUL, 0x466298FCUL,
+    0x1871A4D8UL, 0xEA1A27DBUL, 0xF94AD42FUL, 0x0B21572CUL,
+    0xDFEB33C7UL, 0x2D80B0C4UL, 0x3ED04330UL, 0xCCBBC033UL,
+    0xA24BB5A6UL, 0x502036A5UL, 0x4370C551UL, 0xB11B4652UL,
+    0x65D122B9UL, 0x97BAA1BAUL, 0x84EA524EUL, 0x7681D14DUL,
+    0x2892ED69UL, 0xDAF96E6AUL, 0xC9A99D9EUL, 0x3BC21E9DUL,
+    0xEF087A76UL, 0x1D63F975UL, 0x0E330A81UL, 0xFC588982UL,
+    0xB21572C9UL, 0x407EF1CAUL, 0x532E023EUL, 0xA145813DUL,
+    0x758FE5D6UL, 0x87E466D5UL, 0x94B49521UL, 0x66DF1622UL,
+    0x38CC2A06UL, 0xCAA7A905UL, 0xD9F75AF1UL, 0x2B9CD9F2UL,
+    0xFF56BD19UL, 0x0D3D3E1AUL, 0x1E6DCDEEUL, 0xEC064EEDUL,
+    0xC38D26C4UL, 0x31E6A5C7UL, 0x22B65633UL, 0xD0DDD530UL,
+    0x0417B1DBUL, 0xF67C32D8UL, 0xE52CC12CUL, 0x1747422FUL,
+    0x49547E0BUL, 0xBB3FFD08UL, 0xA86F0EFCUL, 0x5A048DFFUL,
+    0x8ECEE914UL, 0x7CA56A17UL, 0x6FF599E3UL, 0x9D9E1AE0UL,
+    0xD3D3E1ABUL, 0x21B862A8UL, 0x32E8915CUL, 0xC083125FUL,
+    0x144976B4UL, 0xE622F5B7UL, 0xF5720643UL, 0x07198540UL,
+    0x590AB964UL, 0xAB613A67UL, 0xB831C993UL, 0x4A5A4A90UL,
+    0x9E902E7BUL, 0x6CFBAD78UL, 0x7FAB5E8CUL, 0x8DC0DD8FUL,
+    0xE330A81AUL, 0x115B2B19UL, 0x020BD8EDUL, 0xF0605BEEUL,
+    0x24AA3F05UL, 0xD6C1BC06UL, 0xC5914FF2UL, 0x37FACCF1UL,
+    0x69E9F0D5UL, 0x9B8273D6UL, 0x88D28022UL, 0x7AB90321UL,
+    0xAE7367CAUL, 0x5C18E4C9UL, 0x4F48173DUL, 0xBD23943EUL,
+    0xF36E6F75UL, 0x0105EC76UL, 0x12551F82UL, 0xE03E9C81UL,
+    0x34F4F86AUL, 0xC69F7B69UL, 0xD5CF889DUL, 0x27A40B9EUL,
+    0x79B737BAUL, 0x8BDCB4B9UL, 0x988C474DUL, 0x6AE7C44EUL,
+    0xBE2DA0A5UL, 0x4C4623A6UL, 0x5F16D052UL, 0xAD7D5351UL
+};
+
+VEC2_API unsigned long
+vec2_crc32c(unsigned long crc, const void *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+
+    crc = ~crc & 0xFFFFFFFFUL;
+#ifdef VEC2_USE_SSE42
+    {
+    #if defined(__x86_64__) || defined(_M_X64)
+        size_t word;
+        for (; size >= sizeof(word); size -= sizeof(word))
+        {
+            memcpy(&word, p, sizeof(word));
+            crc = (unsigned long)_mm_crc32_u64(crc, word);
+            p += sizeof(word);
+        }
+    #else
+        unsigned int word;
+        for (; size >= sizeof(word); size -= sizeof(word))
+        {
+            memcpy(&word, p, sizeof(word));
+            crc = _mm_crc32_u32((unsigned int)crc, word);
+            p += sizeof(word);
+        }
+    #endif
+    }
+#endif  /* def VEC2_USE_SSE42 */
+    for (; size > 0; --size)
+    {
+        crc = vec2_crc32c_table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc & 0xFFFFFFFFUL;
+} /* vec2_crc32c */
+
+/****************************************************************************/
+/* stream */
+
+VEC2_INLINE_FN void
+vec2_io_put_le(unsigned char *p, size_t value, size_t bytes)
+{
+    size_t i;
+    for (i = 0; i < bytes; ++i)
+    {
+        p[i] = (unsigned char)(value & 0xFF);
+        value >>= 8;
+    }
+} /* vec2_io_put_le */
+
+/* NOTE: It returns false if the value doesn't fit size_t. */
+VEC2_INLINE_FN bool
+vec2_io_get_le(const unsigned char *p, size_t bytes, size_t *pvalue)
+{
+    size_t value = 0;
+    while (bytes-- > 0)
+    {
+        if (value > ((size_t)-1 >> 8))
+        {
+            return false;
+        }
+        value = (value << 8) | p[bytes];
+    }
+    *pvalue = value;
+    return true;
+} /* vec2_io_get_le */
+
+/* NOTE: It writes all the buffers, resuming after the short writes. */
+VEC2_INLINE_FN bool
+vec2_io_writev_all(int fd, struct iovec *iov, int count)
+{
+    ssize_t n;
+    size_t done;
+
+    while (count > 0)
+    {
+        n = writev(fd, iov, count);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        /* skip the written buffers and the written part of the next */
+        done = (size_t)n;
+        while (count > 0 && done >= iov->iov_len)
+        {
+            done -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if (count > 0)
+        {
+            iov->iov_base = (char *)iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+    return true;
+} /* vec2_io_writev_all */
+
+VEC2_API bool vec2_write_fd(int fd, const VEC2 *pv, int flags)
+{
+    unsigned char header[VEC2_STREAM_HEADER_SIZE], trailer[4];
+    struct iovec iov[3];
+    const char *items;
+    size_t size, done, len;
+    unsigned long crc = 0;
+    int count;
+
+    assert(vec2_valid(pv));
+    assert((flags & ~VEC2_IO_CRC32C) == 0);
+
+    memcpy(header, "VEC2", 4);
+    header[4] = VEC2_STREAM_VERSION;
+    header[5] = (unsigned char)flags;
+    header[6] = header[7] = 0;
+    vec2_io_put_le(&header[8], pv->size_per_item, 8);
+    vec2_io_put_le(&header[16], pv->num_items, 8);
+    if (flags & VEC2_IO_CRC32C)
+    {
+        crc = vec2_crc32c(crc, header, sizeof(header));
+    }
+
+    /* the header goes with the first chunk, and the trailer with the last.
+       The CRC of a chunk is computed just before the chunk is written. */
+    items = (const char *)pv->items;
+    size = pv->num_items * pv->size_per_item;
+    done = 0;
+    do
+    {
+        count = 0;
+        if (done == 0)
+        {
+            iov[count].iov_base = header;
+            iov[count].iov_len = sizeof(header);
+            ++count;
+        }
+
+        len = size - done;
+        if (len > VEC2_IO_CHUNK)
+        {
+            len = VEC2_IO_CHUNK;
+        }
+        if (len > 0)
+        {
+            iov[count].iov_base = (void *)&items[done];
+            iov[count].iov_len = len;
+            ++count;
+        }
+        done += len;
+
+        if (flags & VEC2_IO_CRC32C)
+        {
+            crc = vec2_crc32c(crc, &items[done - len], len);
+            if (done == size)
+            {
+                vec2_io_put_le(trailer, crc, 4);
+                iov[count].iov_base = trailer;
+                iov[count].iov_len = sizeof(trailer);
+                ++count;
+            }
+        }
+
+        if (!vec2_io_writev_all(fd, iov, count))
+        {
+            return false;
+        }
+    } while (done < size);
+
+    return true;
+} /* vec2_write_fd */
+
+VEC2_API void vec2_reader_construct(VEC2_READER *pr, PVEC2 pv)
+{
+    assert(pr != NULL);
+    assert(vec2_valid(pv));
+
+    pr->pv = pv;
+    pr->done = 0;
+    pr->total = VEC2_STREAM_HEADER_SIZE;
+    pr->num_items = 0;
+    pr->crc = 0;
+    pr->flags = 0;
+} /* vec2_reader_construct */
+
+/* NOTE: It checks the header read, and clears the items of the vec2. */
+VEC2_INLINE_FN bool vec2_reader_parse(VEC2_READER *pr)
+{
+    const unsigned char *header = pr->header;
+    size_t size_per_item, num_items;
+
+    if (memcmp(header, "VEC2", 4) != 0 ||
+        header[4] != VEC2_STREAM_VERSION ||
+        (header[5] & ~VEC2_IO_CRC32C) != 0 ||
+        header[6] != 0 || header[7] != 0)
+    {
+        return false;
+    }
+    if (!vec2_io_get_le(&header[8], 8, &size_per_item) ||
+        !vec2_io_get_le(&header[16], 8, &num_items) ||
+        size_per_item != pr->pv->size_per_item ||
+        num_items > pr->pv->capacity)
+    {
+        return false;
+    }
+
+    pr->flags = header[5];
+    pr->num_items = num_items;
+    pr->total = VEC2_STREAM_HEADER_SIZE + num_items * size_per_item;
+    if (pr->flags & VEC2_IO_CRC32C)
+    {
+        pr->total += sizeof(pr->trailer);
+        pr->crc = vec2_crc32c(0, header, VEC2_STREAM_HEADER_SIZE);
+    }
+    pr->pv->num_items = 0;
+    return true;
+} /* vec2_reader_parse */
+
+VEC2_API int vec2_reader_read(VEC2_READER *pr, int fd)
+{
+    struct iovec iov[2];
+    size_t size, offset, len, skip, crc;
+    ssize_t n;
+    char *items;
+    int count;
+
+    assert(pr != NULL);
+    assert(vec2_valid(pr->pv));
+
+    items = (char *)pr->pv->items;
+    size = offset = len = 0;
+    while (pr->done < pr->total)
+    {
+        count = 0;
+        if (pr->done < VEC2_STREAM_HEADER_SIZE)
+        {
+            /* the header first, to know the size of the rest */
+            iov[count].iov_base = &pr->header[pr->done];
+            iov[count].iov_len = VEC2_STREAM_HEADER_SIZE - pr->done;
+            ++count;
+        }
+        else
+        {
+            /* the items straight into the block, and the trailer */
+            size = pr->num_items * pr->pv->size_per_item;
+            offset = pr->done - VEC2_STREAM_HEADER_SIZE;
+            len = 0;
+            if (offset < size)
+            {
+                len = size - offset;
+                if (len > VEC2_IO_CHUNK)
+                {
+                    len = VEC2_IO_CHUNK;
+                }
+                iov[count].iov_base = &items[offset];
+                iov[count].iov_len = len;
+                ++count;
+            }
+            if ((pr->flags & VEC2_IO_CRC32C) && offset + len >= size)
+            {
+                skip = offset + len - size;     /* the trailer bytes read */
+                iov[count].iov_base = &pr->trailer[skip];
+                iov[count].iov_len = sizeof(pr->trailer) - skip;
+                ++count;
+            }
+        }
+
+        n = readv(fd, iov, count);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return VEC2_IO_AGAIN;
+            }
+            return VEC2_IO_ERROR;
+        }
+        if (n == 0)
+        {
+            /* the stream ended early */
+            return VEC2_IO_ERROR;
+        }
+
+        if (pr->done < VEC2_STREAM_HEADER_SIZE)
+        {
+            pr->done += (size_t)n;
+            if (pr->done == VEC2_STREAM_HEADER_SIZE && !vec2_reader_parse(pr))
+            {
+                return VEC2_IO_ERROR;
+            }
+        }
+        else
+        {
+            if ((pr->flags & VEC2_IO_CRC32C) && offset < size)
+            {
+                pr->crc = vec2_crc32c(pr->crc, &items[offset],
+                                      ((size_t)n < len) ? (size_t)n : len);
+            }
+            pr->done += (size_t)n;
+        }
+    }
+
+    if (pr->flags & VEC2_IO_CRC32C)
+    {
+        if (!vec2_io_get_le(pr->trailer, sizeof(pr->trailer), &crc) ||
+            crc != pr->crc)
+        {
+            return VEC2_IO_ERROR;
+        }
+    }
+    pr->pv->num_items = pr->num_items;
+    vec2_mark_dirty(pr->pv, 0, pr->num_items);
+    return VEC2_IO_DONE;
+} /* vec2_reader_read */
+
+VEC2_API bool vec2_read_fd(int fd, PVEC2 pv)
+{
+    VEC2_READER reader;
+    int ret;
+
+    vec2_reader_construct(&reader, pv);
+    do
+    {
+        ret = vec2_reader_read(&reader, fd);
+    } while (ret == VEC2_IO_AGAIN);
+
+    return ret == VEC2_IO_DONE;
+} /* vec2_read_fd */
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* testing */
+
+/* #define VEC2_IO_TEST */
+
+#ifdef VEC2_IO_TEST
+    #include <stdio.h>
+
+    #define TEST_PATH   "vec2_io_test.map"
+    #define NUM_LONGS   5000
+
+    static long s_longs[NUM_LONGS], s_longs2[NUM_LONGS];
+    static char s_stream[NUM_LONGS * sizeof(long) + 64];
+
+    int main(void)
+    {
+        VEC2_MAPPED mapped;
+        VEC2_MAPPED_HEADER header;
+        VEC2_READER reader;
+        VEC2 vec, vec2;
+        PVEC2 pv;
+        long value;
+        unsigned long crc;
+        size_t i, size;
+        bool ok;
+        int fd, fds[2], flags, ret;
+
+        remove(TEST_PATH);
+
+        /* no file without VEC2_MAP_CREATE */
+        ok = vec2_open_mapped(&mapped, TEST_PATH, sizeof(long), 100, 0);
+        assert(!ok);
+
+        ok = vec2_open_mapped(&mapped, TEST_PATH, sizeof(long), 100,
+                              VEC2_MAP_CREATE);
+        assert(ok);
+        pv = vec2_mapped_vec(&mapped);
+        ok = (vec2_size(pv) == 0 && vec2_capacity(pv) == 100);
+        assert(ok);
+        for (i = 0; i < 100; ++i)
+        {
+            value = (long)i * 3;
+            vec2_push_back(pv, &value);
+        }
+        ok = vec2_sync_mapped(&mapped, 10, 20);
+        assert(ok);
+        vec2_pop_back(pv);
+        ok = vec2_close_mapped(&mapped);
+        assert(ok);
+
+        /* the items and the count are in the file */
+        ok = vec2_open_mapped(&mapped, TEST_PATH, sizeof(long), 0,
+                              VEC2_MAP_READONLY | VEC2_MAP_POPULATE |
+                              VEC2_MAP_SEQUENTIAL);
+        assert(ok);
+        pv = vec2_mapped_vec(&mapped);
+        ok = (vec2_size(pv) == 99 && vec2_capacity(pv) == 100);
+        assert(ok);
+        for (i = 0; i < 99; ++i)
+        {
+            ok = (*(long *)vec2_get_at(pv, i) == (long)i * 3);
+            assert(ok);
+        }
+        ok = vec2_close_mapped(&mapped);
+        assert(ok);
+
+        /* the size of the item must match, and capacity grows by create */
+        ok = vec2_open_mapped(&mapped, TEST_PATH, sizeof(int), 0, 0);
+        assert(!ok);
+        ok = vec2_open_mapped(&mapped, TEST_PATH, sizeof(long), 200, 0);
+        assert(!ok);
+        ok = vec2_open_mapped(&mapped, TEST_PATH, sizeof(long), 200,
+                              VEC2_MAP_CREATE | VEC2_MAP_RANDOM |
+                              VEC2_MAP_ASYNC);
+        assert(ok);
+        pv = vec2_mapped_vec(&mapped);
+        ok = (vec2_size(pv) == 99 && vec2_capacity(pv) == 200);
+        assert(ok);
+        ok = (*(long *)vec2_get_at(pv, 98) == 98 * 3);
+        assert(ok);
+        ok = vec2_close_mapped(&mapped);
+        assert(ok);
+
+        /* a broken header */
+        fd = open(TEST_PATH, O_RDWR);
+        assert(fd != -1);
+        ok = (pread(fd, &header, sizeof(header), 0) ==
+              (ssize_t)sizeof(header));
+        assert(ok);
+        header.num_items = 1000;
+        ok = (pwrite(fd, &header, sizeof(header), 0) ==
+              (ssize_t)sizeof(header));
+        assert(ok);
+        close(fd);
+        ok = vec2_open_mapped(&mapped, TEST_PATH, sizeof(long), 0, 0);
+        assert(!ok);
+
+        remove(TEST_PATH);
+        printf("vec2_io: ok\n");
+
+        /* the check value of CRC32C, and a CRC continued by pieces */
+        ok = (vec2_crc32c(0, "123456789", 9) == 0xE3069283UL);
+        assert(ok);
+        for (i = 0; i < NUM_LONGS; ++i)
+        {
+            s_longs[i] = (long)(i * 2654435761UL);
+        }
+        crc = vec2_crc32c(0, s_longs, 1001);
+        crc = vec2_crc32c(crc, (char *)s_longs + 1001, sizeof(s_longs) - 1001);
+        ok = (crc == vec2_crc32c(0, s_longs, sizeof(s_longs)));
+        assert(ok);
+
+        /* a stream to a file and back */
+        vec2_construct(&vec, sizeof(long), NUM_LONGS, s_longs, NUM_LONGS);
+        vec2_construct(&vec2, sizeof(long), NUM_LONGS, s_longs2, 0);
+        for (flags = 0; flags <= VEC2_IO_CRC32C; ++flags)
+        {
+            fd = open(TEST_PATH, O_RDWR | O_CREAT | O_TRUNC, 0666);
+            assert(fd != -1);
+            ok = vec2_write_fd(fd, &vec, flags);
+            assert(ok);
+            lseek(fd, 0, SEEK_SET);
+            memset(s_longs2, 0, sizeof(s_longs2));
+            ok = vec2_read_fd(fd, &vec2);
+            assert(ok);
+            ok = (vec2_size(&vec2) == NUM_LONGS &&
+                  memcmp(s_longs, s_longs2, sizeof(s_longs)) == 0);
+            assert(ok);
+            close(fd);
+        }
+
+        /* the pieces coming through a non-blocking pipe */
+        fd = open(TEST_PATH, O_RDONLY);
+        assert(fd != -1);
+        size = (size_t)read(fd, s_stream, sizeof(s_stream));
+        close(fd);
+        ok = (pipe(fds) == 0);
+        assert(ok);
+        fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+        memset(s_longs2, 0, sizeof(s_longs2));
+        vec2_reader_construct(&reader, &vec2);
+        for (i = 0; i < size; i += 777)
+        {
+            ret = vec2_reader_read(&reader, fds[0]);
+            assert(ret == VEC2_IO_AGAIN);
+            ok = (write(fds[1], &s_stream[i],
+                        (i + 777 < size) ? 777 : size - i) > 0);
+            assert(ok);
+        }
+        ret = vec2_reader_read(&reader, fds[0]);
+        assert(ret == VEC2_IO_DONE);
+        ok = (vec2_size(&vec2) == NUM_LONGS &&
+              memcmp(s_longs, s_longs2, sizeof(s_longs)) == 0);
+        assert(ok);
+        close(fds[0]);
+        close(fds[1]);
+
+        /* a broken item is found by the CRC */
+        fd = open(TEST_PATH, O_RDWR);
+        assert(fd != -1);
+        ok = (pwrite(fd, "X", 1, VEC2_STREAM_HEADER_SIZE + 100) == 1);
+        assert(ok);
+        lseek(fd, 0, SEEK_SET);
+        ok = vec2_read_fd(fd, &vec2);
+        assert(!ok);
+
+        /* too many items for the block */
+        lseek(fd, 0, SEEK_SET);
+        vec2_construct(&vec2, sizeof(long), NUM_LONGS - 1, s_longs2, 0);
+        ok = vec2_read_fd(fd, &vec2);
+        assert(!ok);
+        close(fd);
+
+        remove(TEST_PATH);
+        printf("vec2_write_fd/vec2_read_fd: ok\n");
+        return 0;
+    } /* main */
+#endif  /* def VEC2_IO_TEST */
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_IO_C */
@@ -0,0 +1,176 @@
+/****************************************************************************/
+/* vec2_io.h --- file I/O of vec2                                           */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_IO_H
+#define KATAHIROMZ_VEC2_IO_H
+
+#include "vec2.h"
+
+/*
+ * NOTE: vec2_io needs POSIX (open, mmap, msync). A mapped file has the
+ *       native byte order and the native size_t. It's not for exchanging
+ *       the data between the machines.
+ *       With VEC2_INLINE, define _POSIX_C_SOURCE (200809L or later) or
+ *       _DEFAULT_SOURCE before any #include, e.g. -D_DEFAULT_SOURCE. A
+ *       strict -std=c89/c99/c11 hides pread(), ftruncate() and
+ *       posix_madvise() otherwise.
+ */
+
+/****************************************************************************/
+/* types */
+
+/* the version of the mapped file format */
+#define VEC2_MAPPED_VERSION     1
+
+/* NOTE: The items of a mapped file start at VEC2_MAPPED_HEADER_SIZE. */
+#define VEC2_MAPPED_HEADER_SIZE 64
+
+/*
+ * NOTE: The last byte of magic is sizeof(size_t). The checksum covers the
+ *       fields before it, and is updated by vec2_sync_mapped().
+ */
+typedef struct VEC2_MAPPED_HEADER
+{
+    char    magic[8];       /* "VEC2MAP" and sizeof(size_t) */
+    size_t  version;        /* VEC2_MAPPED_VERSION */
+    size_t  header_size;    /* VEC2_MAPPED_HEADER_SIZE */
+    size_t  size_per_item;
+    size_t  capacity;
+    size_t  num_items;
+    size_t  checksum;       /* FNV-1a of the fields above */
+} VEC2_MAPPED_HEADER;
+
+/*
+ * VEC2_MAPPED is a vec2 on a memory-mapped file. vec is constructed over
+ * the items of the mapping, so opening a table reads nothing but the
+ * header. The pages are read on the first access.
+ */
+typedef struct VEC2_MAPPED
+{
+    VEC2    vec;            /* the items on the mapping */
+    void *  base;           /* the mapping of the whole file */
+    size_t  map_size;       /* the size of the file */
+    int     fd;
+    int     flags;          /* VEC2_MAP_* */
+} VEC2_MAPPED, *PVEC2_MAPPED;
+
+/* the flags of vec2_open_mapped() */
+#define VEC2_MAP_CREATE     0x01    /* create or grow the file */
+#define VEC2_MAP_READONLY   0x02    /* map read-only; don't modify vec */
+#define VEC2_MAP_POPULATE   0x04    /* read all the pages at opening */
+#define VEC2_MAP_SEQUENTIAL 0x08    /* hint: the items are read in order */
+#define VEC2_MAP_RANDOM     0x10    /* hint: the items are read at random */
+#define VEC2_MAP_ASYNC      0x20    /* vec2_sync_mapped() doesn't wait */
+
+/*
+ * NOTE: A stream is a header of VEC2_STREAM_HEADER_SIZE bytes, the live
+ *       items, and the CRC32C of the header and the items (4 bytes) if
+ *       VEC2_IO_CRC32C. The numbers of the header are little-endian:
+ *
+ *           "VEC2", version (1 byte), flags (1 byte), zero (2 bytes),
+ *           size_per_item (8 bytes), num_items (8 bytes)
+ */
+#define VEC2_STREAM_VERSION     1
+#define VEC2_STREAM_HEADER_SIZE 24
+
+/* the flags of the streams */
+#define VEC2_IO_CRC32C          0x01    /* with the CRC32C trailer */
+
+/* the results of vec2_reader_read() */
+#define VEC2_IO_DONE            1       /* the whole vec2 is read */
+#define VEC2_IO_AGAIN           0       /* call it again when readable */
+#define VEC2_IO_ERROR           (-1)    /* error, or a broken stream */
+
+/* the bytes per writev()/readv() of the items */
+#ifndef VEC2_IO_CHUNK
+    #define VEC2_IO_CHUNK       (256 * 1024)
+#endif
+
+/*
+ * VEC2_READER reads a stream into the fixed block of pv by pieces, as
+ * the data comes. The items go straight into the block. pv->num_items is
+ * set when the whole stream is read.
+ */
+typedef struct VEC2_READER
+{
+    PVEC2           pv;
+    unsigned char   header[VEC2_STREAM_HEADER_SIZE];
+    unsigned char   trailer[4];
+    size_t          done;           /* the bytes read */
+    size_t          total;          /* the bytes of the stream */
+    size_t          num_items;      /* the number of the items coming */
+    unsigned long   crc;            /* the CRC32C of the bytes read */
+    int             flags;          /* the flags of the stream */
+} VEC2_READER;
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* functions */
+
+/*
+ * NOTE: vec2_open_mapped() opens a mapped file and constructs pm->vec over
+ *       it. It returns false if the file can't be opened or mapped, or its
+ *       header is broken or doesn't match size_per_item. Creating a file
+ *       needs VEC2_MAP_CREATE and a non-zero capacity. For an existing file,
+ *       capacity zero means the capacity of the file; a larger one grows
+ *       the file with VEC2_MAP_CREATE, and fails without it.
+ *       vec2_sync_mapped() stores pm->vec.num_items to the header, and
+ *       writes back the header and the pages of count items from index0.
+ *       vec2_close_mapped() syncs all the items unless read-only, and
+ *       unmaps the file.
+ */
+VEC2_API bool
+vec2_open_mapped(PVEC2_MAPPED pm, const char *path, size_t size_per_item,
+                 size_t capacity, int flags);
+VEC2_API bool
+vec2_sync_mapped(PVEC2_MAPPED pm, size_t index0, size_t count);
+VEC2_API bool vec2_close_mapped(PVEC2_MAPPED pm);
+
+/*
+ * NOTE: vec2_write_fd() writes the live items of pv to a blocking fd as a
+ *       stream. flags is VEC2_IO_CRC32C or zero. vec2_read_fd() reads a
+ *       stream from a blocking fd and replaces the items of pv. It returns
+ *       false if the stream is broken, or doesn't fit pv. With a
+ *       non-blocking fd, call vec2_reader_read() when the fd is readable
+ *       until it returns VEC2_IO_DONE or VEC2_IO_ERROR.
+ */
+VEC2_API bool vec2_write_fd(int fd, const VEC2 *pv, int flags);
+VEC2_API bool vec2_read_fd(int fd, PVEC2 pv);
+VEC2_API void vec2_reader_construct(VEC2_READER *pr, PVEC2 pv);
+VEC2_API int vec2_reader_read(VEC2_READER *pr, int fd);
+
+/* NOTE: vec2_crc32c() continues crc with size bytes. Start with zero.
+ *       It uses the crc32 instruction of SSE4.2 if enabled (-msse4.2). */
+VEC2_API unsigned long
+vec2_crc32c(unsigned long crc, const void *data, size_t size);
+
+/****************************************************************************/
+/* function macros */
+
+#define vec2_mapped_vec(pm)     (&(pm)->vec)
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* header-only build */
+
+#ifdef VEC2_INLINE
+    #include "vec2_io.c"
+#endif
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_IO_H */
@@ -0,0 +1,485 @@
+/****************************************************************************/
+/* vec2_queue.c --- lock-free bounded queues of vec2                        */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_QUEUE_C
+#define KATAHIROMZ_VEC2_QUEUE_C
+
+#include "vec2_queue.h"
+#include <stddef.h>
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* helpers */
+
+/* the largest power of two not greater than capacity */
+VEC2_INLINE_FN size_t vec2_queue_round(size_t capacity)
+{
+    size_t n = 1;
+    assert(capacity > 0U);
+    while (n <= capacity / 2U)
+    {
+        n *= 2U;
+    }
+    return n;
+} /* vec2_queue_round */
+
+/* copies count items from src to the slots from pos, wrapping around */
+VEC2_INLINE_FN void
+vec2_queue_copy_in(void *items, size_t capacity, size_t size_per_item,
+                   size_t pos, const void *src, size_t count)
+{
+    char *ptr = (char *)items;
+    size_t count1;
+
+    pos &= capacity - 1U;
+    count1 = capacity - pos;
+    if (count1 > count)
+    {
+        count1 = count;
+    }
+    memcpy(&ptr[pos * size_per_item], src, count1 * size_per_item);
+    if (count1 < count)
+    {
+        memcpy(ptr, (const char *)src + count1 * size_per_item,
+               (count - count1) * size_per_item);
+    }
+} /* vec2_queue_copy_in */
+
+/* copies count items of the slots from pos to dest, wrapping around */
+VEC2_INLINE_FN void
+vec2_queue_copy_out(const void *items, size_t capacity, size_t size_per_item,
+                    size_t pos, void *dest, size_t count)
+{
+    const char *ptr = (const char *)items;
+    size_t count1;
+
+    pos &= capacity - 1U;
+    count1 = capacity - pos;
+    if (count1 > count)
+    {
+        count1 = count;
+    }
+    memcpy(dest, &ptr[pos * size_per_item], count1 * size_per_item);
+    if (count1 < count)
+    {
+        memcpy((char *)dest + count1 * size_per_item, ptr,
+               (count - count1) * size_per_item);
+    }
+} /* vec2_queue_copy_out */
+
+/****************************************************************************/
+/* single producer, single consumer */
+
+VEC2_API void
+vec2_spsc_construct(VEC2_SPSC *pq, size_t size_per_item, size_t capacity,
+                    void *items)
+{
+    assert(pq != NULL);
+    assert(items != NULL);
+    assert(size_per_item > 0U);
+
+    pq->items = items;
+    pq->capacity = vec2_queue_round(capacity);
+    pq->size_per_item = size_per_item;
+    VEC2_ATOMIC_INIT(pq->tail, 0);
+    VEC2_ATOMIC_INIT(pq->head, 0);
+    pq->head_cache = 0;
+    pq->tail_cache = 0;
+} /* vec2_spsc_construct */
+
+VEC2_API size_t
+vec2_spsc_enqueue(VEC2_SPSC *pq, const void *items, size_t count)
+{
+    size_t tail, room;
+
+    assert(pq != NULL);
+    assert((items != NULL) || (count == 0U));
+
+    tail = VEC2_LOAD_RELAXED(pq->tail);
+    room = pq->capacity - (tail - pq->head_cache);
+    if (room < count)
+    {
+        pq->head_cache = VEC2_LOAD_ACQUIRE(pq->head);
+        room = pq->capacity - (tail - pq->head_cache);
+    }
+    if (count > room)
+    {
+        count = room;
+    }
+    if (count > 0U)
+    {
+        vec2_queue_copy_in(pq->items, pq->capacity, pq->size_per_item,
+                           tail, items, count);
+        VEC2_STORE_RELEASE(pq->tail, tail + count);
+    }
+    return count;
+} /* vec2_spsc_enqueue */
+
+VEC2_API size_t
+vec2_spsc_dequeue(VEC2_SPSC *pq, void *items, size_t count)
+{
+    size_t head, avail;
+
+    assert(pq != NULL);
+    assert((items != NULL) || (count == 0U));
+
+    head = VEC2_LOAD_RELAXED(pq->head);
+    avail = pq->tail_cache - head;
+    if (avail < count)
+    {
+        pq->tail_cache = VEC2_LOAD_ACQUIRE(pq->tail);
+        avail = pq->tail_cache - head;
+    }
+    if (count > avail)
+    {
+        count = avail;
+    }
+    if (count > 0U)
+    {
+        vec2_queue_copy_out(pq->items, pq->capacity, pq->size_per_item,
+                            head, items, count);
+        VEC2_STORE_RELEASE(pq->head, head + count);
+    }
+    return count;
+} /* vec2_spsc_dequeue */
+
+VEC2_API bool vec2_spsc_push(VEC2_SPSC *pq, const void *pitem)
+{
+    return vec2_spsc_enqueue(pq, pitem, 1) == 1U;
+} /* vec2_spsc_push */
+
+VEC2_API bool vec2_spsc_pop(VEC2_SPSC *pq, void *pitem)
+{
+    return vec2_spsc_dequeue(pq, pitem, 1) == 1U;
+} /* vec2_spsc_pop */
+
+/****************************************************************************/
+/* multiple producers, multiple consumers */
+
+/*
+ * NOTE: The slot of position pos waits for the producer if its sequence
+ *       number is pos, and for the consumer if it's pos + 1. The consumer
+ *       sets it to pos + capacity for the next lap. A run of slots is
+ *       claimed by one CAS of the position, after checking that all the
+ *       slots of the run are ready; no one else touches them meanwhile.
+ */
+
+/* the signed distance of the sequence number seq from expected */
+#define VEC2_SEQ_DIFF(seq,expected)     ((ptrdiff_t)((seq) - (expected)))
+
+VEC2_API void
+vec2_mpmc_construct(VEC2_MPMC *pq, size_t size_per_item, size_t capacity,
+                    void *items, VEC2_ATOMIC_SIZE *seqs)
+{
+    size_t i;
+
+    assert(pq != NULL);
+    assert(items != NULL);
+    assert(seqs != NULL);
+    assert(size_per_item > 0U);
+
+    pq->items = items;
+    pq->seqs = seqs;
+    pq->capacity = vec2_queue_round(capacity);
+    pq->size_per_item = size_per_item;
+    for (i = 0; i < pq->capacity; ++i)
+    {
+        VEC2_ATOMIC_INIT(seqs[i], i);
+    }
+    VEC2_ATOMIC_INIT(pq->enqueue_pos, 0);
+    VEC2_ATOMIC_INIT(pq->dequeue_pos, 0);
+} /* vec2_mpmc_construct */
+
+VEC2_API size_t
+vec2_mpmc_enqueue(VEC2_MPMC *pq, const void *items, size_t count)
+{
+    size_t pos, n, i, mask, seq = 0;
+
+    assert(pq != NULL);
+    assert((items != NULL) || (count == 0U));
+
+    if (count == 0U)
+    {
+        return 0;
+    }
+    mask = pq->capacity - 1U;
+    pos = VEC2_LOAD_RELAXED(pq->enqueue_pos);
+    for (;;)
+    {
+        /* the ready slots from pos */
+        for (n = 0; n < count && n < pq->capacity; ++n)
+        {
+            seq = VEC2_LOAD_ACQUIRE(pq->seqs[(pos + n) & mask]);
+            if (seq != pos + n)
+            {
+                break;
+            }
+        }
+        if (n > 0U)
+        {
+            if (VEC2_CAS_RELAXED(pq->enqueue_pos, &pos, pos + n))
+            {
+                break;
+            }
+            /* pos is updated by the failed CAS */
+        }
+        else if (VEC2_SEQ_DIFF(seq, pos) < 0)
+        {
+            /* the slot still has the item of the last lap */
+            return 0;
+        }
+        else
+        {
+            pos = VEC2_LOAD_RELAXED(pq->enqueue_pos);
+        }
+    }
+
+    vec2_queue_copy_in(pq->items, pq->capacity, pq->size_per_item,
+                       pos, items, n);
+    for (i = 0; i < n; ++i)
+    {
+        VEC2_STORE_RELEASE(pq->seqs[(pos + i) & mask], pos + i + 1U);
+    }
+    return n;
+} /* vec2_mpmc_enqueue */
+
+VEC2_API size_t
+vec2_mpmc_dequeue(VEC2_MPMC *pq, void *items, size_t count)
+{
+    size_t pos, n, i, mask, seq = 0;
+
+    assert(pq != NULL);
+    assert((items != NULL) || (count == 0U));
+
+    if (count == 0U)
+    {
+        return 0;
+    }
+    mask = pq->capacity - 1U;
+    pos = VEC2_LOAD_RELAXED(pq->dequeue_pos);
+    for (;;)
+    {
+        /* the filled slots from pos */
+        for (n = 0; n < count && n < pq->capacity; ++n)
+        {
+            seq = VEC2_LOAD_ACQUIRE(pq->seqs[(pos + n) & mask]);
+            if (seq != pos + n + 1U)
+            {
+                break;
+            }
+        }
+        if (n > 0U)
+        {
+            if (VEC2_CAS_RELAXED(pq->dequeue_pos, &pos, pos + n))
+            {
+                break;
+            }
+        }
+        else if (VEC2_SEQ_DIFF(seq, pos + 1U) < 0)
+        {
+            /* empty */
+            return 0;
+        }
+        else
+        {
+            pos = VEC2_LOAD_RELAXED(pq->dequeue_pos);
+        }
+    }
+
+    vec2_queue_copy_out(pq->items, pq->capacity, pq->size_per_item,
+                        pos, items, n);
+    for (i = 0; i < n; ++i)
+    {
+        VEC2_STORE_RELEASE(pq->seqs[(pos + i) & mask],
+                           pos + i + pq->capacity);
+    }
+    return n;
+} /* vec2_mpmc_dequeue */
+
+VEC2_API bool vec2_mpmc_push(VEC2_MPMC *pq, const void *pitem)
+{
+    return vec2_mpmc_enqueue(pq, pitem, 1) == 1U;
+} /* vec2_mpmc_push */
+
+VEC2_API bool vec2_mpmc_pop(VEC2_MPMC *pq, void *pitem)
+{
+    return vec2_mpmc_dequeue(pq, pitem, 1) == 1U;
+} /* vec2_mpmc_pop */
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* testing */
+
+/* #define VEC2_QUEUE_TEST */
+
+#ifdef VEC2_QUEUE_TEST
+    #include <stdio.h>
+    #include <pthread.h>
+
+    #define NUM_VALUES      200000
+    #define NUM_PRODUCERS   2
+    #define NUM_CONSUMERS   2
+
+    static VEC2_SPSC s_spsc;
+    static VEC2_MPMC s_mpmc;
+    static long s_spsc_items[1000];     /* rounded down to 512 */
+    static long s_mpmc_items[256];
+    static VEC2_ATOMIC_SIZE s_seqs[256];
+    static unsigned char s_seen[NUM_PRODUCERS * NUM_VALUES];
+    static long s_sums[NUM_CONSUMERS];
+
+    void *spsc_producer(void *arg)
+    {
+        long values[7];
+        long n = 0;
+        size_t i, count = 0, added;
+        while (n < NUM_VALUES)
+        {
+            /* runs of 1 to 7 items */
+            count = (count % 7U) + 1U;
+            for (i = 0; i < count; ++i)
+            {
+                values[i] = n + (long)i;
+            }
+            if (n + (long)count > NUM_VALUES)
+            {
+                count = (size_t)(NUM_VALUES - n);
+            }
+            added = vec2_spsc_enqueue(&s_spsc, values, count);
+            n += (long)added;
+        }
+        return arg;
+    }
+
+    void *mpmc_producer(void *arg)
+    {
+        long id = (long)(size_t)arg, values[5];
+        long n = 0;
+        size_t i, count, added;
+        while (n < NUM_VALUES)
+        {
+            count = (size_t)(n % 5) + 1U;
+            if (n + (long)count > NUM_VALUES)
+            {
+                count = (size_t)(NUM_VALUES - n);
+            }
+            for (i = 0; i < count; ++i)
+            {
+                values[i] = id * NUM_VALUES + n + (long)i;
+            }
+            added = vec2_mpmc_enqueue(&s_mpmc, values, count);
+            n += (long)added;
+        }
+        return NULL;
+    }
+
+    void *mpmc_consumer(void *arg)
+    {
+        long id = (long)(size_t)arg, values[3], v, stop = -1;
+        size_t i, count, stops = 0;
+        while (stops == 0)
+        {
+            count = vec2_mpmc_dequeue(&s_mpmc, values, 3);
+            for (i = 0; i < count; ++i)
+            {
+                v = values[i];
+                if (v < 0)
+                {
+                    ++stops;
+                    continue;
+                }
+                assert(s_seen[v] == 0);
+                s_seen[v] = 1;
+                s_sums[id] += v;
+            }
+        }
+        /* give back the stops of the others */
+        for (; stops > 1; --stops)
+        {
+            while (!vec2_mpmc_push(&s_mpmc, &stop))
+            {
+                ;
+            }
+        }
+        return NULL;
+    }
+
+    int main(void)
+    {
+        pthread_t producers[NUM_PRODUCERS], consumers[NUM_CONSUMERS];
+        pthread_t thread;
+        long values[4], expected = 0, sum, stop = -1;
+        size_t i, count;
+        bool ok;
+
+        /* SPSC: the values come in order */
+        vec2_spsc_construct(&s_spsc, sizeof(long), 1000, s_spsc_items);
+        assert(s_spsc.capacity == 512);
+        pthread_create(&thread, NULL, spsc_producer, NULL);
+        while (expected < NUM_VALUES)
+        {
+            count = vec2_spsc_dequeue(&s_spsc, values, 4);
+            for (i = 0; i < count; ++i)
+            {
+                ok = (values[i] == expected++);
+                assert(ok);
+            }
+        }
+        pthread_join(thread, NULL);
+        ok = !vec2_spsc_pop(&s_spsc, values);
+        assert(ok);
+        printf("vec2_spsc: ok\n");
+
+        /* MPMC: each value comes once */
+        vec2_mpmc_construct(&s_mpmc, sizeof(long), 256, s_mpmc_items, s_seqs);
+        for (i = 0; i < NUM_CONSUMERS; ++i)
+        {
+            pthread_create(&consumers[i], NULL, mpmc_consumer, (void *)i);
+        }
+        for (i = 0; i < NUM_PRODUCERS; ++i)
+        {
+            pthread_create(&producers[i], NULL, mpmc_producer, (void *)i);
+        }
+        for (i = 0; i < NUM_PRODUCERS; ++i)
+        {
+            pthread_join(producers[i], NULL);
+        }
+        for (i = 0; i < NUM_CONSUMERS; ++i)
+        {
+            while (!vec2_mpmc_push(&s_mpmc, &stop))
+            {
+                ;
+            }
+        }
+        sum = 0;
+        for (i = 0; i < NUM_CONSUMERS; ++i)
+        {
+            pthread_join(consumers[i], NULL);
+            sum += s_sums[i];
+        }
+        ok = (sum == (long)NUM_PRODUCERS * NUM_VALUES *
+                     ((long)NUM_PRODUCERS * NUM_VALUES - 1) / 2);
+        assert(ok);
+        printf("vec2_mpmc: ok\n");
+
+        return 0;
+    } /* main */
+#endif  /* def VEC2_QUEUE_TEST */
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_QUEUE_C */
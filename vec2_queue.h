@@ -0,0 +1,149 @@
+/****************************************************************************/
+/* vec2_queue.h --- lock-free bounded queues of vec2                        */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_QUEUE_H
+#define KATAHIROMZ_VEC2_QUEUE_H
+
+#include "vec2.h"
+
+/*
+ * NOTE: The queues are lock-free on a fixed block of items supplied by the
+ *       caller. VEC2_SPSC has one producer thread and one consumer thread.
+ *       VEC2_MPMC has any number of them, and needs a block of sequence
+ *       numbers of the same capacity. The capacity is rounded down to a
+ *       power of two.
+ *       They need C11 atomics, or the __atomic builtins of GCC/Clang (for
+ *       C89 and C++).
+ */
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && \
+    !defined(__STDC_NO_ATOMICS__) && !defined(__cplusplus)
+    #include <stdatomic.h>
+    typedef atomic_size_t VEC2_ATOMIC_SIZE;
+    #define VEC2_ATOMIC_INIT(x,value)   atomic_init(&(x), (value))
+    #define VEC2_LOAD_RELAXED(x) \
+        atomic_load_explicit(&(x), memory_order_relaxed)
+    #define VEC2_LOAD_ACQUIRE(x) \
+        atomic_load_explicit(&(x), memory_order_acquire)
+    #define VEC2_STORE_RELEASE(x,value) \
+        atomic_store_explicit(&(x), (value), memory_order_release)
+    #define VEC2_CAS_RELAXED(x,pexpected,value) \
+        atomic_compare_exchange_weak_explicit(&(x), (pexpected), (value), \
+            memory_order_relaxed, memory_order_relaxed)
+    #define VEC2_FETCH_ADD_RELAXED(x,value) \
+        atomic_fetch_add_explicit(&(x), (value), memory_order_relaxed)
+#elif defined(__GNUC__) || defined(__clang__)
+    typedef size_t VEC2_ATOMIC_SIZE;
+    #define VEC2_ATOMIC_INIT(x,value)   ((x) = (value))
+    #define VEC2_LOAD_RELAXED(x)        __atomic_load_n(&(x), __ATOMIC_RELAXED)
+    #define VEC2_LOAD_ACQUIRE(x)        __atomic_load_n(&(x), __ATOMIC_ACQUIRE)
+    #define VEC2_STORE_RELEASE(x,value) \
+        __atomic_store_n(&(x), (value), __ATOMIC_RELEASE)
+    #define VEC2_CAS_RELAXED(x,pexpected,value) \
+        __atomic_compare_exchange_n(&(x), (pexpected), (value), 1, \
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+    #define VEC2_FETCH_ADD_RELAXED(x,value) \
+        __atomic_fetch_add(&(x), (value), __ATOMIC_RELAXED)
+#else
+    #error vec2_queue needs C11 atomics or GCC atomic builtins.
+#endif
+
+/* the size of a cache line */
+#ifndef VEC2_CACHE_LINE
+    #define VEC2_CACHE_LINE     64
+#endif
+
+/****************************************************************************/
+/* types */
+
+/*
+ * NOTE: head and tail count the items ever dequeued and enqueued. Each
+ *       side keeps a copy of the other side's index on its own cache line,
+ *       and reads the shared one only when the copy says empty or full.
+ */
+typedef struct VEC2_SPSC
+{
+    void *              items;          /* Not malloc'ed. It's a fixed block. */
+    size_t              capacity;       /* a power of two */
+    size_t              size_per_item;
+    char                pad0[VEC2_CACHE_LINE];
+    VEC2_ATOMIC_SIZE    tail;           /* written by the producer */
+    size_t              head_cache;     /* the producer's copy of head */
+    char                pad1[VEC2_CACHE_LINE];
+    VEC2_ATOMIC_SIZE    head;           /* written by the consumer */
+    size_t              tail_cache;     /* the consumer's copy of tail */
+    char                pad2[VEC2_CACHE_LINE];
+} VEC2_SPSC;
+
+/*
+ * NOTE: The sequence number of each slot tells whether it waits for the
+ *       producer or the consumer of a position (Vyukov's bounded queue).
+ */
+typedef struct VEC2_MPMC
+{
+    void *              items;          /* Not malloc'ed. It's a fixed block. */
+    VEC2_ATOMIC_SIZE *  seqs;           /* the sequence numbers of the slots */
+    size_t              capacity;       /* a power of two */
+    size_t              size_per_item;
+    char                pad0[VEC2_CACHE_LINE];
+    VEC2_ATOMIC_SIZE    enqueue_pos;
+    char                pad1[VEC2_CACHE_LINE];
+    VEC2_ATOMIC_SIZE    dequeue_pos;
+    char                pad2[VEC2_CACHE_LINE];
+} VEC2_MPMC;
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* functions */
+
+/*
+ * NOTE: vec2_spsc_enqueue() and vec2_mpmc_enqueue() add count items at most
+ *       as one run and return the number added. It is less than count if
+ *       the queue gets full. The dequeue functions copy count items at most
+ *       to items and return the number. The runs of the MPMC functions are
+ *       contiguous in the queue order.
+ */
+VEC2_API void
+vec2_spsc_construct(VEC2_SPSC *pq, size_t size_per_item, size_t capacity,
+                    void *items);
+VEC2_API size_t
+vec2_spsc_enqueue(VEC2_SPSC *pq, const void *items, size_t count);
+VEC2_API size_t
+vec2_spsc_dequeue(VEC2_SPSC *pq, void *items, size_t count);
+VEC2_API bool vec2_spsc_push(VEC2_SPSC *pq, const void *pitem);
+VEC2_API bool vec2_spsc_pop(VEC2_SPSC *pq, void *pitem);
+
+VEC2_API void
+vec2_mpmc_construct(VEC2_MPMC *pq, size_t size_per_item, size_t capacity,
+                    void *items, VEC2_ATOMIC_SIZE *seqs);
+VEC2_API size_t
+vec2_mpmc_enqueue(VEC2_MPMC *pq, const void *items, size_t count);
+VEC2_API size_t
+vec2_mpmc_dequeue(VEC2_MPMC *pq, void *items, size_t count);
+VEC2_API bool vec2_mpmc_push(VEC2_MPMC *pq, const void *pitem);
+VEC2_API bool vec2_mpmc_pop(VEC2_MPMC *pq, void *pitem);
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* header-only build */
+
+#ifdef VEC2_INLINE
+    #include "vec2_queue.c"
+#endif
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_QUEUE_H */
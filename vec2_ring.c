@@ -0,0 +1,354 @@
+/****************************************************************************/
+/* vec2_ring.c --- ring buffer of vec2                                      */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_RING_C
+#define KATAHIROMZ_VEC2_RING_C
+
+#include "vec2_ring.h"
+
+/****************************************************************************/
+/* status checking */
+
+#ifndef vec2_status_bad
+    #define vec2_status_bad(pv)    assert(0)
+#endif
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* helpers */
+
+/* copies count items from src to the block at pos, wrapping around */
+VEC2_INLINE_FN void
+vec2_ring_write_at(PVEC2_RING pr, size_t pos, const void *src, size_t count)
+{
+    char *ptr = (char *)pr->items;
+    size_t count1 = pr->capacity - pos;
+
+    if (count1 > count)
+    {
+        count1 = count;
+    }
+    memcpy(&ptr[pos * pr->size_per_item], src, count1 * pr->size_per_item);
+    memcpy(ptr, (const char *)src + count1 * pr->size_per_item,
+           (count - count1) * pr->size_per_item);
+} /* vec2_ring_write_at */
+
+/****************************************************************************/
+/* functions */
+
+VEC2_API bool vec2_ring_valid(const VEC2_RING *pr)
+{
+    bool ret;
+
+    if ((pr == NULL) || (pr->num_items > pr->capacity))
+    {
+        ret = false;
+    }
+    else if ((pr->capacity != 0U) && (pr->head >= pr->capacity))
+    {
+        ret = false;
+    }
+    else if ((pr->capacity != 0U) && (pr->items == NULL))
+    {
+        ret = false;
+    }
+    else if (pr->size_per_item == 0U)
+    {
+        ret = false;
+    }
+    else
+    {
+        ret = true;
+    }
+
+    return ret;
+} /* vec2_ring_valid */
+
+#ifndef NDEBUG
+    VEC2_API void *vec2_ring_item(PVEC2_RING pr, size_t index0)
+    {
+        char *p;
+        assert(vec2_ring_valid(pr));
+        assert(index0 < vec2_ring_size(pr));
+        p = (char *)pr->items;
+        return (void *)(p + vec2_ring_pos(pr, index0) * pr->size_per_item);
+    } /* vec2_ring_item */
+#endif  /* ndef NDEBUG */
+
+VEC2_API vec2_bool
+vec2_ring_construct(PVEC2_RING pr, size_t size_per_item,
+                    size_t capacity, void *items, size_t num_items)
+{
+    VEC2_STATUS_INIT(ret, true);
+    assert(items != NULL);
+
+    /* NOTE: vec2 doesn't allocate memory. Just weakly refers. */
+    pr->items = items;
+    pr->size_per_item = size_per_item;
+    pr->num_items = num_items;
+    pr->capacity = capacity;
+    pr->head = 0;
+
+    assert(vec2_ring_valid(pr));
+
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_ring_construct */
+
+VEC2_API void vec2_ring_clear(PVEC2_RING pr)
+{
+    assert(vec2_ring_valid(pr));
+    pr->num_items = 0;
+    pr->head = 0;
+} /* vec2_ring_clear */
+
+VEC2_API vec2_bool vec2_ring_push_back(PVEC2_RING pr, const void *pitem)
+{
+    char *ptr;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_ring_valid(pr));
+    assert(pitem != NULL);
+
+    if (pr->num_items < pr->capacity)
+    {
+        ptr = (char *)pr->items;
+        memcpy(&ptr[vec2_ring_pos(pr, pr->num_items) * pr->size_per_item],
+               pitem, pr->size_per_item);
+        pr->num_items += 1U;
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(pr);
+    }
+
+    assert(vec2_ring_valid(pr));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_ring_push_back */
+
+VEC2_API vec2_bool vec2_ring_push_front(PVEC2_RING pr, const void *pitem)
+{
+    char *ptr;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_ring_valid(pr));
+    assert(pitem != NULL);
+
+    if (pr->num_items < pr->capacity)
+    {
+        pr->head = (pr->head == 0U) ? pr->capacity - 1U : pr->head - 1U;
+        ptr = (char *)pr->items;
+        memcpy(&ptr[pr->head * pr->size_per_item], pitem, pr->size_per_item);
+        pr->num_items += 1U;
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(pr);
+    }
+
+    assert(vec2_ring_valid(pr));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_ring_push_front */
+
+VEC2_API vec2_bool vec2_ring_pop_back(PVEC2_RING pr)
+{
+    VEC2_STATUS_INIT(ret, false);
+    assert(vec2_ring_valid(pr));
+    if (pr->num_items > 0U)
+    {
+        pr->num_items -= 1U;
+        VEC2_STATUS_SET(ret, true);
+    }
+    assert(vec2_ring_valid(pr));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_ring_pop_back */
+
+VEC2_API vec2_bool vec2_ring_pop_front(PVEC2_RING pr)
+{
+    VEC2_STATUS_INIT(ret, false);
+    assert(vec2_ring_valid(pr));
+    if (pr->num_items > 0U)
+    {
+        pr->head = vec2_ring_pos(pr, 1U);
+        pr->num_items -= 1U;
+        VEC2_STATUS_SET(ret, true);
+    }
+    assert(vec2_ring_valid(pr));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_ring_pop_front */
+
+VEC2_API size_t
+vec2_ring_append(PVEC2_RING pr, const void *items, size_t count)
+{
+    assert(vec2_ring_valid(pr));
+    assert((items != NULL) || (count == 0U));
+
+    if (count > pr->capacity - pr->num_items)
+    {
+        count = pr->capacity - pr->num_items;
+    }
+    if (count > 0U)
+    {
+        vec2_ring_write_at(pr, vec2_ring_pos(pr, pr->num_items), items,
+                           count);
+        pr->num_items += count;
+    }
+
+    assert(vec2_ring_valid(pr));
+    return count;
+} /* vec2_ring_append */
+
+VEC2_API size_t vec2_ring_pop_front_n(PVEC2_RING pr, size_t count)
+{
+    assert(vec2_ring_valid(pr));
+
+    if (count > pr->num_items)
+    {
+        count = pr->num_items;
+    }
+    if (count > 0U)
+    {
+        pr->head = vec2_ring_pos(pr, count);
+        pr->num_items -= count;
+    }
+
+    assert(vec2_ring_valid(pr));
+    return count;
+} /* vec2_ring_pop_front_n */
+
+VEC2_API void
+vec2_ring_read(const VEC2_RING *pr, size_t index0, size_t count,
+               void *dest)
+{
+    const char *ptr;
+    size_t pos, count1;
+
+    assert(vec2_ring_valid(pr));
+    assert(index0 + count <= pr->num_items);
+    assert((dest != NULL) || (count == 0U));
+
+    if (count == 0U)
+    {
+        return;
+    }
+    ptr = (const char *)pr->items;
+    pos = vec2_ring_pos(pr, index0);
+    count1 = pr->capacity - pos;
+    if (count1 > count)
+    {
+        count1 = count;
+    }
+    memcpy(dest, &ptr[pos * pr->size_per_item], count1 * pr->size_per_item);
+    memcpy((char *)dest + count1 * pr->size_per_item, ptr,
+           (count - count1) * pr->size_per_item);
+} /* vec2_ring_read */
+
+VEC2_API void
+vec2_ring_two_spans(PVEC2_RING pr, void **pfirst, size_t *pcount1,
+                    void **psecond, size_t *pcount2)
+{
+    char *ptr;
+
+    assert(vec2_ring_valid(pr));
+    assert(pfirst != NULL);
+    assert(pcount1 != NULL);
+    assert(psecond != NULL);
+    assert(pcount2 != NULL);
+
+    ptr = (char *)pr->items;
+    *pfirst = &ptr[pr->head * pr->size_per_item];
+    *psecond = ptr;
+    if (pr->num_items > pr->capacity - pr->head)
+    {
+        *pcount1 = pr->capacity - pr->head;
+        *pcount2 = pr->num_items - *pcount1;
+    }
+    else
+    {
+        *pcount1 = pr->num_items;
+        *pcount2 = 0;
+    }
+} /* vec2_ring_two_spans */
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* testing */
+
+/* #define VEC2_RING_TEST */
+
+#ifdef VEC2_RING_TEST
+    #include <stdio.h>
+
+    int main(void)
+    {
+        static long items[8], out[8];
+        VEC2_RING ring;
+        void *first, *second;
+        size_t count1, count2, count;
+        long n;
+
+        vec2_ring_construct(&ring, sizeof(long), 8, items, 0);
+        for (n = 0; n < 6; ++n)
+        {
+            vec2_ring_push_back(&ring, &n);
+        }
+        /* 0 1 2 3 4 5 */
+        count = vec2_ring_pop_front_n(&ring, 4);
+        assert(count == 4);
+        n = -1;
+        vec2_ring_push_front(&ring, &n);
+        /* -1 4 5 */
+        assert(vec2_ring_size(&ring) == 3 && ring.head == 3);
+        assert(*(long *)vec2_ring_front(&ring) == -1);
+
+        /* a sliding window wraps around */
+        {
+            static const long more[] = { 6, 7, 8, 9, 10 };
+            count = vec2_ring_append(&ring, more, 5);
+            assert(count == 5 && vec2_ring_full(&ring));
+        }
+        /* -1 4 5 6 7 8 9 10 */
+        assert(*(long *)vec2_ring_back(&ring) == 10);
+        assert(*(long *)vec2_ring_item(&ring, 5) == 8);
+        vec2_ring_two_spans(&ring, &first, &count1, &second, &count2);
+        assert(count1 == 5 && count2 == 3);
+        assert(*(long *)first == -1 && *(long *)second == 8);
+        vec2_ring_read(&ring, 2, 6, out);
+        assert(out[0] == 5 && out[3] == 8 && out[5] == 10);
+
+        vec2_ring_pop_front(&ring);
+        vec2_ring_pop_back(&ring);
+        /* 4 5 6 7 8 9 */
+        assert(vec2_ring_size(&ring) == 6);
+        assert(*(long *)vec2_ring_front(&ring) == 4);
+        assert(*(long *)vec2_ring_back(&ring) == 9);
+        count = vec2_ring_pop_front_n(&ring, 100);
+        assert(count == 6 && vec2_ring_empty(&ring));
+        vec2_ring_two_spans(&ring, &first, &count1, &second, &count2);
+        assert(count1 == 0 && count2 == 0);
+
+        printf("vec2_ring: ok\n");
+        return 0;
+    } /* main */
+#endif  /* def VEC2_RING_TEST */
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_RING_C */
@@ -0,0 +1,119 @@
+/****************************************************************************/
+/* vec2_ring.h --- ring buffer of vec2                                      */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_RING_H
+#define KATAHIROMZ_VEC2_RING_H
+
+#include "vec2.h"
+
+/****************************************************************************/
+/* types */
+
+/*
+ * VEC2_RING is a vec2 whose items start at head and wrap around the end
+ * of the fixed block. Both ends are pushed and popped in O(1).
+ */
+typedef struct VEC2_RING
+{
+    void *  items;          /* Not malloc'ed. It's a fixed block. */
+    size_t  num_items;      /* number of items alive */
+    size_t  capacity;       /* number of items allocated */
+    size_t  size_per_item;  /* the size of one item */
+    size_t  head;           /* the position of the front item in the block */
+} VEC2_RING, *PVEC2_RING;
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* functions */
+
+/* NOTE: The first num_items items of the block are the initial items. */
+VEC2_API vec2_bool
+vec2_ring_construct(PVEC2_RING pr, size_t size_per_item,
+                    size_t capacity, void *items, size_t num_items);
+VEC2_API void vec2_ring_clear(PVEC2_RING pr);
+
+VEC2_API vec2_bool vec2_ring_push_back(PVEC2_RING pr, const void *pitem);
+VEC2_API vec2_bool vec2_ring_push_front(PVEC2_RING pr, const void *pitem);
+VEC2_API vec2_bool vec2_ring_pop_back(PVEC2_RING pr);
+VEC2_API vec2_bool vec2_ring_pop_front(PVEC2_RING pr);
+
+/*
+ * bulk operations
+ * NOTE: vec2_ring_append() returns the number of items added. It is less
+ *       than count if the fixed block gets full. vec2_ring_pop_front_n()
+ *       returns the number of items popped. vec2_ring_read() copies count
+ *       items from index0 to dest.
+ */
+VEC2_API size_t
+vec2_ring_append(PVEC2_RING pr, const void *items, size_t count);
+VEC2_API size_t vec2_ring_pop_front_n(PVEC2_RING pr, size_t count);
+VEC2_API void
+vec2_ring_read(const VEC2_RING *pr, size_t index0, size_t count,
+               void *dest);
+
+/*
+ * NOTE: vec2_ring_two_spans() stores the items in order as two contiguous
+ *       spans. The second one is empty unless the items wrap around.
+ */
+VEC2_API void
+vec2_ring_two_spans(PVEC2_RING pr, void **pfirst, size_t *pcount1,
+                    void **psecond, size_t *pcount2);
+
+/* validation for debugging */
+VEC2_API bool vec2_ring_valid(const VEC2_RING *pr);
+
+#ifndef NDEBUG
+    VEC2_API void *vec2_ring_item(PVEC2_RING pr, size_t index0);
+#endif
+
+/****************************************************************************/
+/* function macros */
+
+#define vec2_ring_empty(pr)         ((pr)->num_items == 0)
+#define vec2_ring_full(pr)          ((pr)->num_items == (pr)->capacity)
+#define vec2_ring_size(pr)          ((pr)->num_items)
+#define vec2_ring_capacity(pr)      (*(const size_t *)&(pr)->capacity)
+
+/* NOTE: vec2_ring_pos() is the position of index0 in the block. */
+#define vec2_ring_pos(pr,index0) ( \
+    ((pr)->head + (index0) >= (pr)->capacity) ? \
+    (pr)->head + (index0) - (pr)->capacity : (pr)->head + (index0) \
+)
+
+#ifdef NDEBUG
+    #define vec2_ring_item(pr,index0) ( \
+        (void *)( \
+            ((char *)(pr)->items) + \
+            vec2_ring_pos((pr), (index0)) * (pr)->size_per_item \
+        ) \
+    )
+#endif
+
+#define vec2_ring_front(pr)         vec2_ring_item((pr), 0)
+#define vec2_ring_back(pr)          vec2_ring_item((pr), (pr)->num_items - 1)
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* header-only build */
+
+#ifdef VEC2_INLINE
+    #include "vec2_ring.c"
+#endif
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_RING_H */
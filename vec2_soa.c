@@ -0,0 +1,458 @@
+/****************************************************************************/
+/* vec2_soa.c --- structure-of-arrays vec2                                  */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_SOA_C
+#define KATAHIROMZ_VEC2_SOA_C
+
+#include "vec2_soa.h"
+
+/****************************************************************************/
+/* status checking */
+
+#ifndef vec2_status_bad
+    #define vec2_status_bad(pv)    assert(0)
+#endif
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* functions */
+
+VEC2_API bool vec2_soa_valid(const VEC2_SOA *ps)
+{
+    bool ret;
+    size_t i;
+
+    if ((ps == NULL) || (ps->num_items > ps->capacity))
+    {
+        ret = false;
+    }
+    else if ((ps->num_columns == 0U) ||
+             (ps->num_columns > VEC2_SOA_MAX_COLUMNS))
+    {
+        ret = false;
+    }
+    else
+    {
+        ret = true;
+        for (i = 0; i < ps->num_columns; ++i)
+        {
+            if (ps->column_sizes[i] == 0U)
+            {
+                ret = false;
+            }
+            else if ((ps->capacity != 0U) && (ps->columns[i] == NULL))
+            {
+                ret = false;
+            }
+        }
+    }
+
+    return ret;
+} /* vec2_soa_valid */
+
+#ifndef NDEBUG
+    VEC2_API void *
+    vec2_soa_item(PVEC2_SOA ps, size_t column, size_t index0)
+    {
+        char *p;
+        assert(vec2_soa_valid(ps));
+        assert(column < ps->num_columns);
+        assert(index0 < vec2_soa_size(ps));
+        p = (char *)ps->columns[column];
+        return (void *)(p + index0 * ps->column_sizes[column]);
+    } /* vec2_soa_item */
+#endif  /* ndef NDEBUG */
+
+VEC2_API vec2_bool
+vec2_soa_construct(PVEC2_SOA ps, size_t capacity, size_t num_columns,
+                   void *const *columns, const size_t *sizes,
+                   size_t num_items)
+{
+    size_t i;
+    VEC2_STATUS_INIT(ret, true);
+    assert(columns != NULL);
+    assert(sizes != NULL);
+    assert(num_columns <= VEC2_SOA_MAX_COLUMNS);
+
+    /* NOTE: vec2 doesn't allocate memory. Just weakly refers. */
+    for (i = 0; i < num_columns; ++i)
+    {
+        ps->columns[i] = columns[i];
+        ps->column_sizes[i] = sizes[i];
+    }
+    ps->num_columns = num_columns;
+    ps->num_items = num_items;
+    ps->capacity = capacity;
+
+    assert(vec2_soa_valid(ps));
+
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_soa_construct */
+
+VEC2_API void vec2_soa_clear(PVEC2_SOA ps)
+{
+    assert(vec2_soa_valid(ps));
+    ps->num_items = 0;
+} /* vec2_soa_clear */
+
+VEC2_API vec2_bool
+vec2_soa_push_back(PVEC2_SOA ps, const void *const *fields)
+{
+#ifdef VEC2_QUICK_BUT_RISKY
+    vec2_soa_insert(ps, ps->num_items, fields);
+#else
+    return vec2_soa_insert(ps, ps->num_items, fields);
+#endif
+} /* vec2_soa_push_back */
+
+VEC2_API vec2_bool
+vec2_soa_insert(PVEC2_SOA ps, size_t index0, const void *const *fields)
+{
+    char *ptr;
+    size_t i, size;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_soa_valid(ps));
+    assert(index0 <= vec2_soa_size(ps));
+    assert(fields != NULL);
+
+    if (ps->num_items < ps->capacity)
+    {
+        for (i = 0; i < ps->num_columns; ++i)
+        {
+            assert(fields[i] != NULL);
+            ptr = (char *)ps->columns[i];
+            size = ps->column_sizes[i];
+            memmove(&ptr[(index0 + 1) * size], &ptr[index0 * size],
+                    (ps->num_items - index0) * size);
+            memcpy(&ptr[index0 * size], fields[i], size);
+        }
+        ++ps->num_items;
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(ps);
+    }
+
+    assert(vec2_soa_valid(ps));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_soa_insert */
+
+VEC2_API void
+vec2_soa_get(const VEC2_SOA *ps, size_t index0, void *const *fields)
+{
+    const char *ptr;
+    size_t i, size;
+
+    assert(vec2_soa_valid(ps));
+    assert(index0 < vec2_soa_size(ps));
+    assert(fields != NULL);
+
+    for (i = 0; i < ps->num_columns; ++i)
+    {
+        if (fields[i] != NULL)
+        {
+            ptr = (const char *)ps->columns[i];
+            size = ps->column_sizes[i];
+            memcpy(fields[i], &ptr[index0 * size], size);
+        }
+    }
+} /* vec2_soa_get */
+
+VEC2_API vec2_bool vec2_soa_pop_back(PVEC2_SOA ps)
+{
+    VEC2_STATUS_INIT(ret, false);
+    assert(vec2_soa_valid(ps));
+    if (ps->num_items > 0U)
+    {
+        ps->num_items -= 1U;
+        VEC2_STATUS_SET(ret, true);
+    }
+    assert(vec2_soa_valid(ps));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_soa_pop_back */
+
+VEC2_API vec2_bool vec2_soa_erase(PVEC2_SOA ps, size_t index0)
+{
+#ifdef VEC2_QUICK_BUT_RISKY
+    vec2_soa_erase_range(ps, index0, 1);
+#else
+    return vec2_soa_erase_range(ps, index0, 1);
+#endif
+} /* vec2_soa_erase */
+
+VEC2_API vec2_bool
+vec2_soa_erase_range(PVEC2_SOA ps, size_t index0, size_t count)
+{
+    char *ptr;
+    size_t i, size;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_soa_valid(ps));
+    assert(index0 + count <= vec2_soa_size(ps));
+
+    if (index0 + count <= ps->num_items)
+    {
+        for (i = 0; i < ps->num_columns; ++i)
+        {
+            ptr = (char *)ps->columns[i];
+            size = ps->column_sizes[i];
+            memmove(&ptr[index0 * size], &ptr[(index0 + count) * size],
+                    (ps->num_items - index0 - count) * size);
+        }
+        ps->num_items -= count;
+        VEC2_STATUS_SET(ret, true);
+    }
+    else
+    {
+        /* status bad */
+        vec2_status_bad(ps);
+    }
+
+    assert(vec2_soa_valid(ps));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_soa_erase_range */
+
+VEC2_API void
+vec2_soa_order_by_key(const VEC2_SOA *ps, size_t column,
+                      VEC2_KEY_TYPE key_type, size_t *perm, void *scratch)
+{
+    VEC2 pairs, rest;
+    char *ptr;
+    const char *keys;
+    size_t i, num_items, key_size, index_offset, pair_size;
+
+    assert(vec2_soa_valid(ps));
+    assert(column < ps->num_columns);
+    assert(perm != NULL);
+    assert(scratch != NULL);
+
+    /* sort the pairs of (key, index) instead of the records */
+    num_items = ps->num_items;
+    if (num_items == 0U)
+    {
+        /* NOTE: the pairs and the rest would be at the same address */
+        return;
+    }
+    key_size = ps->column_sizes[column];
+    index_offset = (key_size + sizeof(size_t) - 1) / sizeof(size_t) *
+                   sizeof(size_t);
+    pair_size = index_offset + sizeof(size_t);
+
+    ptr = (char *)scratch;
+    keys = (const char *)ps->columns[column];
+    for (i = 0; i < num_items; ++i)
+    {
+        memcpy(&ptr[i * pair_size], &keys[i * key_size], key_size);
+        memcpy(&ptr[i * pair_size + index_offset], &i, sizeof(size_t));
+    }
+
+    vec2_construct(&pairs, pair_size, num_items, ptr, num_items);
+    vec2_construct(&rest, pair_size, num_items,
+                   &ptr[num_items * pair_size], 0);
+    vec2_sort_by_key(&pairs, 0, key_size, key_type, &rest);
+
+    for (i = 0; i < num_items; ++i)
+    {
+        memcpy(&perm[i], &ptr[i * pair_size + index_offset], sizeof(size_t));
+    }
+} /* vec2_soa_order_by_key */
+
+/* copies the items of src in the order of perm to dest */
+VEC2_INLINE_FN void
+vec2_soa_gather(char *dest, const char *src, const size_t *perm,
+                size_t count, size_t size)
+{
+    size_t i;
+
+    /* NOTE: The constant sizes let memcpy be a load and a store. */
+    switch (size)
+    {
+    case 4:
+        for (i = 0; i < count; ++i)
+            memcpy(&dest[i * 4], &src[perm[i] * 4], 4);
+        break;
+    case 8:
+        for (i = 0; i < count; ++i)
+            memcpy(&dest[i * 8], &src[perm[i] * 8], 8);
+        break;
+    default:
+        for (i = 0; i < count; ++i)
+            memcpy(&dest[i * size], &src[perm[i] * size], size);
+        break;
+    }
+} /* vec2_soa_gather */
+
+VEC2_API void
+vec2_soa_permute(PVEC2_SOA ps, const size_t *perm, void *scratch)
+{
+    char *ptr;
+    size_t i, size;
+
+    assert(vec2_soa_valid(ps));
+    assert(perm != NULL);
+    assert(scratch != NULL);
+
+    /* NOTE: Each column is gathered into scratch and copied back, so only
+     *       one column is in the cache at a time. */
+    for (i = 0; i < ps->num_columns; ++i)
+    {
+        ptr = (char *)ps->columns[i];
+        size = ps->column_sizes[i];
+        vec2_soa_gather((char *)scratch, ptr, perm, ps->num_items, size);
+        memcpy(ptr, scratch, ps->num_items * size);
+    }
+
+    assert(vec2_soa_valid(ps));
+} /* vec2_soa_permute */
+
+VEC2_API void
+vec2_soa_sort_by_key(PVEC2_SOA ps, size_t column, VEC2_KEY_TYPE key_type,
+                     size_t *perm, void *scratch)
+{
+    vec2_soa_order_by_key(ps, column, key_type, perm, scratch);
+    vec2_soa_permute(ps, perm, scratch);
+} /* vec2_soa_sort_by_key */
+
+VEC2_API void
+vec2_soa_column_vec(PVEC2_SOA ps, size_t column, PVEC2 pv)
+{
+    assert(vec2_soa_valid(ps));
+    assert(column < ps->num_columns);
+    assert(pv != NULL);
+
+    /* NOTE: The view can't grow, or the columns would get out of step. */
+    vec2_construct(pv, ps->column_sizes[column], ps->num_items,
+                   ps->columns[column], ps->num_items);
+} /* vec2_soa_column_vec */
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* testing */
+
+/* #define VEC2_SOA_TEST */
+
+#ifdef VEC2_SOA_TEST
+    #include <stdio.h>
+
+    #define NUM     8
+
+    int main(void)
+    {
+        static int ids[NUM];
+        static double values[NUM];
+        static char tags[NUM];
+        static size_t perm[NUM];
+        static char scratch[VEC2_SOA_SCRATCH_SIZE(NUM, sizeof(double))];
+        static const double data[] = { 3.5, -1.0, 2.0, 3.5, -7.25, 2.0 };
+        static const int sorted_ids[] = { 4, 1, 2, 5, 0, 3 };
+        void *columns[3];
+        size_t sizes[3], i;
+        const void *in[3];
+        void *out[3];
+        VEC2_SOA soa;
+        VEC2 view, sub;
+        int id, sum;
+        double value;
+        char tag;
+        bool ok;
+
+        columns[0] = ids;       sizes[0] = sizeof(int);
+        columns[1] = values;    sizes[1] = sizeof(double);
+        columns[2] = tags;      sizes[2] = sizeof(char);
+        vec2_soa_construct(&soa, NUM, 3, columns, sizes, 0);
+
+        /* sorting nothing */
+        vec2_soa_sort_by_key(&soa, 1, VEC2_KEY_FLOAT, perm, scratch);
+        assert(vec2_soa_empty(&soa));
+
+        /* push_back, insert and erase keep the columns in step */
+        in[0] = &id;
+        in[1] = &value;
+        in[2] = &tag;
+        for (i = 0; i < 6; ++i)
+        {
+            id = (int)i;
+            value = data[i];
+            tag = (char)('a' + i);
+            vec2_soa_push_back(&soa, in);
+        }
+        id = 100;
+        value = 0.5;
+        tag = 'z';
+        vec2_soa_insert(&soa, 2, in);
+        assert(vec2_soa_size(&soa) == 7);
+        assert(*(int *)vec2_soa_item(&soa, 0, 2) == 100);
+        assert(tags[3] == 'c');
+        vec2_soa_erase(&soa, 2);
+        assert(ids[2] == 2 && values[2] == 2.0 && tags[2] == 'c');
+        vec2_soa_push_back(&soa, in);
+        vec2_soa_pop_back(&soa);
+        assert(vec2_soa_size(&soa) == 6);
+
+        /* stable sort by the double column */
+        vec2_soa_sort_by_key(&soa, 1, VEC2_KEY_FLOAT, perm, scratch);
+        ok = true;
+        for (i = 0; i < 6; ++i)
+        {
+            ok = ok && (ids[i] == sorted_ids[i]);
+            ok = ok && (values[i] == data[ids[i]]);
+            ok = ok && (tags[i] == 'a' + ids[i]);
+            ok = ok && (perm[i] == (size_t)sorted_ids[i]);
+        }
+        assert(ok);
+
+        /* get copies the chosen fields */
+        id = 0;
+        out[0] = &id;
+        out[1] = NULL;
+        out[2] = &tag;
+        vec2_soa_get(&soa, 0, out);
+        assert(id == 4 && tag == 'e');
+
+        /* a column is a vec2 without copying */
+        vec2_soa_column_vec(&soa, 0, &view);
+        assert(vec2_data(&view) == (void *)ids);
+        assert(vec2_size(&view) == 6);
+        sum = 0;
+        for (i = 0; i < vec2_size(&view); ++i)
+            sum += *(int *)vec2_get_at(&view, i);
+        assert(sum == 0 + 1 + 2 + 3 + 4 + 5);
+
+        vec2_soa_erase_range(&soa, 1, 4);
+        assert(vec2_soa_size(&soa) == 2);
+        assert(ids[0] == 4 && ids[1] == 3 && tags[1] == 'd');
+        vec2_soa_column_vec(&soa, 2, &sub);
+        assert(memcmp(vec2_data(&sub), "ed", 2) == 0);
+
+        vec2_soa_clear(&soa);
+        assert(vec2_soa_empty(&soa));
+#ifndef VEC2_QUICK_BUT_RISKY
+        ok = !vec2_soa_pop_back(&soa);
+        assert(ok);
+#endif
+
+        printf("vec2_soa: ok\n");
+        return 0;
+    } /* main */
+#endif  /* def VEC2_SOA_TEST */
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_SOA_C */
@@ -0,0 +1,142 @@
+/****************************************************************************/
+/* vec2_soa.h --- structure-of-arrays vec2                                  */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_SOA_H
+#define KATAHIROMZ_VEC2_SOA_H
+
+#include "vec2.h"
+
+/****************************************************************************/
+/* types */
+
+/* the maximum number of the columns */
+#ifndef VEC2_SOA_MAX_COLUMNS
+    #define VEC2_SOA_MAX_COLUMNS    16
+#endif
+
+/*
+ * VEC2_SOA is a vec2 of records stored by columns. Each field of the
+ * records is a column of its own fixed block, and the columns share
+ * num_items and capacity. A pass over one field reads its column only.
+ */
+typedef struct VEC2_SOA
+{
+    void *  columns[VEC2_SOA_MAX_COLUMNS];      /* Not malloc'ed. */
+    size_t  column_sizes[VEC2_SOA_MAX_COLUMNS]; /* the size of each field */
+    size_t  num_columns;
+    size_t  num_items;      /* number of records alive */
+    size_t  capacity;       /* number of records allocated */
+} VEC2_SOA, *PVEC2_SOA;
+
+/*
+ * NOTE: The scratch of vec2_soa_sort_by_key() and vec2_soa_permute() is
+ *       VEC2_SOA_SCRATCH_SIZE() bytes. max_size is the largest size of
+ *       the columns.
+ */
+#define VEC2_SOA_SCRATCH_SIZE(capacity,max_size) \
+    (2U * (capacity) * ((max_size) + 2U * sizeof(size_t)))
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* functions */
+
+/* NOTE: columns[i] is a fixed block of capacity items of sizes[i] bytes.
+ *       The first num_items records of the blocks are the initial ones. */
+VEC2_API vec2_bool
+vec2_soa_construct(PVEC2_SOA ps, size_t capacity, size_t num_columns,
+                   void *const *columns, const size_t *sizes,
+                   size_t num_items);
+VEC2_API void vec2_soa_clear(PVEC2_SOA ps);
+
+/*
+ * record operations
+ * NOTE: fields has a pointer for each column. vec2_soa_push_back() and
+ *       vec2_soa_insert() copy the fields from them, and vec2_soa_get()
+ *       copies the fields of the record to them.
+ */
+VEC2_API vec2_bool
+vec2_soa_push_back(PVEC2_SOA ps, const void *const *fields);
+VEC2_API vec2_bool
+vec2_soa_insert(PVEC2_SOA ps, size_t index0, const void *const *fields);
+VEC2_API void
+vec2_soa_get(const VEC2_SOA *ps, size_t index0, void *const *fields);
+VEC2_API vec2_bool vec2_soa_pop_back(PVEC2_SOA ps);
+VEC2_API vec2_bool vec2_soa_erase(PVEC2_SOA ps, size_t index0);
+VEC2_API vec2_bool
+vec2_soa_erase_range(PVEC2_SOA ps, size_t index0, size_t count);
+
+/*
+ * sorting
+ * NOTE: vec2_soa_order_by_key() stores the stable order of the records by
+ *       the key column to perm (perm[i] is the index of the i-th record).
+ *       The key is the whole field, in the order of vec2_sort_by_key().
+ *       vec2_soa_permute() moves the records into the order of perm,
+ *       column by column. vec2_soa_sort_by_key() does both.
+ */
+VEC2_API void
+vec2_soa_order_by_key(const VEC2_SOA *ps, size_t column,
+                      VEC2_KEY_TYPE key_type, size_t *perm, void *scratch);
+VEC2_API void
+vec2_soa_permute(PVEC2_SOA ps, const size_t *perm, void *scratch);
+VEC2_API void
+vec2_soa_sort_by_key(PVEC2_SOA ps, size_t column, VEC2_KEY_TYPE key_type,
+                     size_t *perm, void *scratch);
+
+/* NOTE: vec2_soa_column_vec() stores a vec2 of the items of the column to
+ *       pv without copying. The view is valid until the next change of
+ *       num_items. */
+VEC2_API void
+vec2_soa_column_vec(PVEC2_SOA ps, size_t column, PVEC2 pv);
+
+/* validation for debugging */
+VEC2_API bool vec2_soa_valid(const VEC2_SOA *ps);
+
+#ifndef NDEBUG
+    VEC2_API void *
+    vec2_soa_item(PVEC2_SOA ps, size_t column, size_t index0);
+#endif
+
+/****************************************************************************/
+/* function macros */
+
+#define vec2_soa_empty(ps)          ((ps)->num_items == 0)
+#define vec2_soa_size(ps)           ((ps)->num_items)
+#define vec2_soa_capacity(ps)       (*(const size_t *)&(ps)->capacity)
+
+/* NOTE: vec2_soa_column() is the span of the items of the column. */
+#define vec2_soa_column(ps,column)  ((ps)->columns[column])
+
+#ifdef NDEBUG
+    #define vec2_soa_item(ps,column,index0) ( \
+        (void *)( \
+            ((char *)(ps)->columns[column]) + \
+            (index0) * (ps)->column_sizes[column] \
+        ) \
+    )
+#endif
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* header-only build */
+
+#ifdef VEC2_INLINE
+    #include "vec2_soa.c"
+#endif
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_SOA_H */
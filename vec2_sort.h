@@ -0,0 +1,635 @@
+/****************************************************************************/
+/* vec2_sort.h --- inlined-comparator sorting for vec2                      */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_SORT_H
+#define KATAHIROMZ_VEC2_SORT_H     0  /* Version 0 */
+
+#include "vec2.h"
+
+/*
+ * VEC2_DECLARE_SORT(name, T, LESS) generates the sorting functions of the
+ * items of type T. LESS(pitem1, pitem2) is a function-like macro or an
+ * inline function that returns non-zero if *pitem1 is less than *pitem2.
+ * The comparison is inlined and items are moved as T.
+ *
+ *     void name(T *items, size_t count);
+ *         pattern-defeating quicksort (not stable)
+ *     void name##_vec2(PVEC2 pv);
+ *         the same for a vec2 whose item size is sizeof(T)
+ *     void name##_stable(T *items, size_t count, T *scratch);
+ *         merge sort (stable). scratch can hold count items.
+ *     vec2_bool name##_stable_vec2(PVEC2 pv, PVEC2 scratch);
+ *         the same for a vec2
+ *
+ * VEC2_DECLARE_SEARCH(name, T, LESS) generates the branchless binary
+ * searches and the updates of the sorted items of type T.
+ *
+ *     size_t name##_lower_bound(const T *items, size_t count, const T *key);
+ *         the index of the first item not less than *key
+ *     size_t name##_upper_bound(const T *items, size_t count, const T *key);
+ *         the index of the first item greater than *key
+ *     size_t name##_equal_range(const T *items, size_t count, const T *key,
+ *                               size_t *pcount);
+ *         the index of the first item equal to *key, and the number
+ *     vec2_bool name##_insert_sorted(PVEC2 pv, const T *pitem);
+ *         inserts *pitem after the equal items
+ *     size_t name##_erase_key(PVEC2 pv, const T *key);
+ *         erases the items equal to *key and returns the number
+ *
+ * Example:
+ *
+ *     typedef struct REC { int key1, key2; } REC;
+ *     #define REC_LESS(a,b) \
+ *         ((a)->key1 < (b)->key1 || \
+ *          ((a)->key1 == (b)->key1 && (a)->key2 < (b)->key2))
+ *     VEC2_DECLARE_SORT(rec_sort, REC, REC_LESS)
+ *     VEC2_DECLARE_SEARCH(rec_search, REC, REC_LESS)
+ */
+
+#ifndef vec2_status_bad
+    #define vec2_status_bad(pv)    assert(0)
+#endif
+
+/* the size under which insertion sort is used */
+#define VEC2_SORT_INSERTION     24
+/* the size over which the ninther is used for the pivot */
+#define VEC2_SORT_NINTHER       128
+/* the limit of moves of partial insertion sort */
+#define VEC2_SORT_PARTIAL_LIMIT 8
+/* the run length of the merge sort */
+#define VEC2_SORT_RUN           16
+
+/****************************************************************************/
+/* insertion sorts */
+
+#define VEC2_DECLARE_SORT_INSERTION_(name,T,LESS) \
+    VEC2_INLINE_FN void name##_insertion_(T *begin, T *end) \
+    { \
+        T *cur, *sift, *sift_1; \
+        T tmp; \
+        if (begin == end) \
+        { \
+            return; \
+        } \
+        for (cur = begin + 1; cur != end; ++cur) \
+        { \
+            sift = cur; \
+            sift_1 = cur - 1; \
+            if (LESS(sift, sift_1)) \
+            { \
+                tmp = *sift; \
+                do \
+                { \
+                    *sift-- = *sift_1; \
+                } while (sift != begin && LESS(&tmp, --sift_1)); \
+                *sift = tmp; \
+            } \
+        } \
+    } \
+    \
+    /* NOTE: *(begin - 1) must not be greater than any item. */ \
+    VEC2_INLINE_FN void name##_unguarded_insertion_(T *begin, T *end) \
+    { \
+        T *cur, *sift, *sift_1; \
+        T tmp; \
+        if (begin == end) \
+        { \
+            return; \
+        } \
+        for (cur = begin + 1; cur != end; ++cur) \
+        { \
+            sift = cur; \
+            sift_1 = cur - 1; \
+            if (LESS(sift, sift_1)) \
+            { \
+                tmp = *sift; \
+                do \
+                { \
+                    *sift-- = *sift_1; \
+                } while (LESS(&tmp, --sift_1)); \
+                *sift = tmp; \
+            } \
+        } \
+    } \
+    \
+    /* gives up if it moves too many items */ \
+    VEC2_INLINE_FN bool name##_partial_insertion_(T *begin, T *end) \
+    { \
+        T *cur, *sift, *sift_1; \
+        T tmp; \
+        size_t limit = 0; \
+        if (begin == end) \
+        { \
+            return true; \
+        } \
+        for (cur = begin + 1; cur != end; ++cur) \
+        { \
+            sift = cur; \
+            sift_1 = cur - 1; \
+            if (LESS(sift, sift_1)) \
+            { \
+                tmp = *sift; \
+                do \
+                { \
+                    *sift-- = *sift_1; \
+                } while (sift != begin && LESS(&tmp, --sift_1)); \
+                *sift = tmp; \
+                limit += (size_t)(cur - sift); \
+            } \
+            if (limit > VEC2_SORT_PARTIAL_LIMIT) \
+            { \
+                return false; \
+            } \
+        } \
+        return true; \
+    }
+
+/****************************************************************************/
+/* helpers of quicksort */
+
+#define VEC2_DECLARE_SORT_HELPER_(name,T,LESS) \
+    VEC2_INLINE_FN void name##_swap_(T *a, T *b) \
+    { \
+        T tmp = *a; \
+        *a = *b; \
+        *b = tmp; \
+    } \
+    \
+    VEC2_INLINE_FN void name##_sort3_(T *a, T *b, T *c) \
+    { \
+        if (LESS(b, a)) \
+        { \
+            name##_swap_(a, b); \
+        } \
+        if (LESS(c, b)) \
+        { \
+            name##_swap_(b, c); \
+        } \
+        if (LESS(b, a)) \
+        { \
+            name##_swap_(a, b); \
+        } \
+    } \
+    \
+    VEC2_INLINE_FN void \
+    name##_sift_down_(T *items, size_t index0, size_t count) \
+    { \
+        size_t child; \
+        T tmp = items[index0]; \
+        for (;;) \
+        { \
+            child = 2 * index0 + 1; \
+            if (child >= count) \
+            { \
+                break; \
+            } \
+            if (child + 1 < count && LESS(&items[child], &items[child + 1])) \
+            { \
+                ++child; \
+            } \
+            if (!LESS(&tmp, &items[child])) \
+            { \
+                break; \
+            } \
+            items[index0] = items[child]; \
+            index0 = child; \
+        } \
+        items[index0] = tmp; \
+    } \
+    \
+    VEC2_INLINE_FN void name##_heapsort_(T *begin, T *end) \
+    { \
+        size_t i, count = (size_t)(end - begin); \
+        for (i = count / 2; i > 0; --i) \
+        { \
+            name##_sift_down_(begin, i - 1, count); \
+        } \
+        for (i = count; i > 1; --i) \
+        { \
+            name##_swap_(&begin[0], &begin[i - 1]); \
+            name##_sift_down_(begin, 0, i - 1); \
+        } \
+    } \
+    \
+    /* partitions [begin, end) around *begin. the items equal to the pivot \
+       go to the right. returns true if it was already partitioned. */ \
+    VEC2_INLINE_FN bool \
+    name##_partition_right_(T *begin, T *end, T **ppivot) \
+    { \
+        T pivot = *begin; \
+        T *first = begin, *last = end; \
+        bool already_partitioned; \
+        while (LESS(++first, &pivot)) \
+        { \
+            ; \
+        } \
+        if (first - 1 == begin) \
+        { \
+            while (first < last && !LESS(--last, &pivot)) \
+            { \
+                ; \
+            } \
+        } \
+        else \
+        { \
+            while (!LESS(--last, &pivot)) \
+            { \
+                ; \
+            } \
+        } \
+        already_partitioned = (first >= last); \
+        while (first < last) \
+        { \
+            name##_swap_(first, last); \
+            while (LESS(++first, &pivot)) \
+            { \
+                ; \
+            } \
+            while (!LESS(--last, &pivot)) \
+            { \
+                ; \
+            } \
+        } \
+        *ppivot = first - 1; \
+        *begin = **ppivot; \
+        **ppivot = pivot; \
+        return already_partitioned; \
+    } \
+    \
+    /* partitions [begin, end) around *begin. the items equal to the pivot \
+       go to the left. used when there are many equal items. */ \
+    VEC2_INLINE_FN T *name##_partition_left_(T *begin, T *end) \
+    { \
+        T pivot = *begin; \
+        T *first = begin, *last = end; \
+        while (LESS(&pivot, --last)) \
+        { \
+            ; \
+        } \
+        if (last + 1 == end) \
+        { \
+            while (first < last && !LESS(&pivot, ++first)) \
+            { \
+                ; \
+            } \
+        } \
+        else \
+        { \
+            while (!LESS(&pivot, ++first)) \
+            { \
+                ; \
+            } \
+        } \
+        while (first < last) \
+        { \
+            name##_swap_(first, last); \
+            while (LESS(&pivot, --last)) \
+            { \
+                ; \
+            } \
+            while (!LESS(&pivot, ++first)) \
+            { \
+                ; \
+            } \
+        } \
+        *begin = *last; \
+        *last = pivot; \
+        return last; \
+    } \
+    \
+    /* breaks the patterns that make the partitions unbalanced */ \
+    VEC2_INLINE_FN void \
+    name##_break_patterns_(T *begin, T *pivot, T *end) \
+    { \
+        size_t l_size = (size_t)(pivot - begin); \
+        size_t r_size = (size_t)(end - (pivot + 1)); \
+        if (l_size >= VEC2_SORT_INSERTION) \
+        { \
+            name##_swap_(begin, begin + l_size / 4); \
+            name##_swap_(pivot - 1, pivot - l_size / 4); \
+            if (l_size > VEC2_SORT_NINTHER) \
+            { \
+                name##_swap_(begin + 1, begin + (l_size / 4 + 1)); \
+                name##_swap_(begin + 2, begin + (l_size / 4 + 2)); \
+                name##_swap_(pivot - 2, pivot - (l_size / 4 + 1)); \
+                name##_swap_(pivot - 3, pivot - (l_size / 4 + 2)); \
+            } \
+        } \
+        if (r_size >= VEC2_SORT_INSERTION) \
+        { \
+            name##_swap_(pivot + 1, pivot + (1 + r_size / 4)); \
+            name##_swap_(end - 1, end - r_size / 4); \
+            if (r_size > VEC2_SORT_NINTHER) \
+            { \
+                name##_swap_(pivot + 2, pivot + (2 + r_size / 4)); \
+                name##_swap_(pivot + 3, pivot + (3 + r_size / 4)); \
+                name##_swap_(end - 2, end - (1 + r_size / 4)); \
+                name##_swap_(end - 3, end - (2 + r_size / 4)); \
+            } \
+        } \
+    }
+
+/****************************************************************************/
+/* pattern-defeating quicksort */
+
+#define VEC2_DECLARE_SORT_PDQ_(name,T,LESS) \
+    VEC2_INLINE_FN void \
+    name##_loop_(T *begin, T *end, int bad_allowed, bool leftmost) \
+    { \
+        size_t size, half; \
+        T *pivot; \
+        bool already_partitioned; \
+        for (;;) \
+        { \
+            size = (size_t)(end - begin); \
+            if (size < VEC2_SORT_INSERTION) \
+            { \
+                if (leftmost) \
+                { \
+                    name##_insertion_(begin, end); \
+                } \
+                else \
+                { \
+                    name##_unguarded_insertion_(begin, end); \
+                } \
+                return; \
+            } \
+            \
+            /* choose the pivot and move it to *begin */ \
+            half = size / 2; \
+            if (size > VEC2_SORT_NINTHER) \
+            { \
+                name##_sort3_(begin, begin + half, end - 1); \
+                name##_sort3_(begin + 1, begin + (half - 1), end - 2); \
+                name##_sort3_(begin + 2, begin + (half + 1), end - 3); \
+                name##_sort3_(begin + (half - 1), begin + half, \
+                              begin + (half + 1)); \
+                name##_swap_(begin, begin + half); \
+            } \
+            else \
+            { \
+                name##_sort3_(begin + half, begin, end - 1); \
+            } \
+            \
+            /* if the pivot equals to the item before, all the items equal \
+               to the pivot are on the left */ \
+            if (!leftmost && !LESS(begin - 1, begin)) \
+            { \
+                begin = name##_partition_left_(begin, end) + 1; \
+                continue; \
+            } \
+            \
+            already_partitioned = name##_partition_right_(begin, end, &pivot); \
+            if ((size_t)(pivot - begin) < size / 8 || \
+                (size_t)(end - (pivot + 1)) < size / 8) \
+            { \
+                /* highly unbalanced */ \
+                if (--bad_allowed == 0) \
+                { \
+                    name##_heapsort_(begin, end); \
+                    return; \
+                } \
+                name##_break_patterns_(begin, pivot, end); \
+            } \
+            else if (already_partitioned && \
+                     name##_partial_insertion_(begin, pivot) && \
+                     name##_partial_insertion_(pivot + 1, end)) \
+            { \
+                return; \
+            } \
+            \
+            name##_loop_(begin, pivot, bad_allowed, leftmost); \
+            begin = pivot + 1; \
+            leftmost = false; \
+        } \
+    } \
+    \
+    VEC2_INLINE_FN void name(T *items, size_t count) \
+    { \
+        int log2 = 0; \
+        size_t n; \
+        for (n = count; n > 1; n >>= 1) \
+        { \
+            ++log2; \
+        } \
+        if (count > 1) \
+        { \
+            name##_loop_(items, items + count, log2, true); \
+        } \
+    } \
+    \
+    VEC2_INLINE_FN void name##_vec2(PVEC2 pv) \
+    { \
+        assert(vec2_valid(pv)); \
+        assert(pv->size_per_item == sizeof(T)); \
+        name((T *)pv->items, pv->num_items); \
+        if (pv->num_items > 1U) \
+        { \
+            vec2_mark_dirty(pv, 0, pv->num_items); \
+        } \
+    }
+
+/****************************************************************************/
+/* merge sort */
+
+#define VEC2_DECLARE_SORT_STABLE_(name,T,LESS) \
+    /* merges [a, a + na) and [b, b + nb) into dest */ \
+    VEC2_INLINE_FN void \
+    name##_merge_(T *dest, const T *a, size_t na, const T *b, size_t nb) \
+    { \
+        const T *a_end = a + na, *b_end = b + nb; \
+        if (na > 0 && nb > 0 && !LESS(b, a_end - 1)) \
+        { \
+            /* already in order */ \
+            memcpy(dest, a, na * sizeof(T)); \
+            memcpy(dest + na, b, nb * sizeof(T)); \
+            return; \
+        } \
+        while (a != a_end && b != b_end) \
+        { \
+            if (LESS(b, a)) \
+            { \
+                *dest++ = *b++; \
+            } \
+            else \
+            { \
+                *dest++ = *a++; \
+            } \
+        } \
+        memcpy(dest, a, (size_t)(a_end - a) * sizeof(T)); \
+        dest += a_end - a; \
+        memcpy(dest, b, (size_t)(b_end - b) * sizeof(T)); \
+    } \
+    \
+    VEC2_INLINE_FN void name##_stable(T *items, size_t count, T *scratch) \
+    { \
+        size_t i, width, na, nb; \
+        T *src = items, *dest = scratch, *tmp; \
+        for (i = 0; i < count; i += VEC2_SORT_RUN) \
+        { \
+            na = count - i; \
+            if (na > VEC2_SORT_RUN) \
+            { \
+                na = VEC2_SORT_RUN; \
+            } \
+            name##_insertion_(&items[i], &items[i + na]); \
+        } \
+        for (width = VEC2_SORT_RUN; width < count; width *= 2) \
+        { \
+            for (i = 0; i < count; i += 2 * width) \
+            { \
+                na = count - i; \
+                if (na > width) \
+                { \
+                    na = width; \
+                } \
+                nb = count - i - na; \
+                if (nb > width) \
+                { \
+                    nb = width; \
+                } \
+                name##_merge_(&dest[i], &src[i], na, &src[i + na], nb); \
+            } \
+            tmp = src; \
+            src = dest; \
+            dest = tmp; \
+        } \
+        if (src != items) \
+        { \
+            memcpy(items, src, count * sizeof(T)); \
+        } \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool name##_stable_vec2(PVEC2 pv, PVEC2 scratch) \
+    { \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(vec2_valid(pv)); \
+        assert(vec2_valid(scratch)); \
+        assert(pv->size_per_item == sizeof(T)); \
+        if (scratch->capacity * scratch->size_per_item >= \
+            pv->num_items * sizeof(T)) \
+        { \
+            name##_stable((T *)pv->items, pv->num_items, \
+                          (T *)scratch->items); \
+            if (pv->num_items > 1U) \
+            { \
+                vec2_mark_dirty(pv, 0, pv->num_items); \
+            } \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        else \
+        { \
+            /* status bad */ \
+            vec2_status_bad(pv); \
+        } \
+        VEC2_STATUS_RETURN(ret); \
+    }
+
+/****************************************************************************/
+/* the generator */
+
+#define VEC2_DECLARE_SORT(name,T,LESS) \
+    VEC2_DECLARE_SORT_INSERTION_(name, T, LESS) \
+    VEC2_DECLARE_SORT_HELPER_(name, T, LESS) \
+    VEC2_DECLARE_SORT_PDQ_(name, T, LESS) \
+    VEC2_DECLARE_SORT_STABLE_(name, T, LESS)
+
+/****************************************************************************/
+/* searching */
+
+#define VEC2_DECLARE_SEARCH(name,T,LESS) \
+    VEC2_INLINE_FN size_t \
+    name##_lower_bound(const T *items, size_t count, const T *key) \
+    { \
+        const T *base = items; \
+        size_t half; \
+        if (count == 0U) \
+        { \
+            return 0; \
+        } \
+        while (count > 1U) \
+        { \
+            half = count / 2; \
+            VEC2_PREFETCH(&base[half / 2]); \
+            VEC2_PREFETCH(&base[half + half / 2]); \
+            base = LESS(&base[half], key) ? &base[half] : base; \
+            count -= half; \
+        } \
+        return (size_t)(base - items) + (LESS(base, key) ? 1U : 0U); \
+    } \
+    \
+    VEC2_INLINE_FN size_t \
+    name##_upper_bound(const T *items, size_t count, const T *key) \
+    { \
+        const T *base = items; \
+        size_t half; \
+        if (count == 0U) \
+        { \
+            return 0; \
+        } \
+        while (count > 1U) \
+        { \
+            half = count / 2; \
+            VEC2_PREFETCH(&base[half / 2]); \
+            VEC2_PREFETCH(&base[half + half / 2]); \
+            base = LESS(key, &base[half]) ? base : &base[half]; \
+            count -= half; \
+        } \
+        return (size_t)(base - items) + (LESS(key, base) ? 0U : 1U); \
+    } \
+    \
+    VEC2_INLINE_FN size_t \
+    name##_equal_range(const T *items, size_t count, const T *key, \
+                       size_t *pcount) \
+    { \
+        size_t first = name##_lower_bound(items, count, key); \
+        *pcount = name##_upper_bound(items, count, key) - first; \
+        return first; \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool name##_insert_sorted(PVEC2 pv, const T *pitem) \
+    { \
+        T *items = (T *)pv->items; \
+        size_t index0; \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(vec2_valid(pv)); \
+        assert(pv->size_per_item == sizeof(T)); \
+        if (pv->num_items < pv->capacity) \
+        { \
+            index0 = name##_upper_bound(items, pv->num_items, pitem); \
+            memmove(&items[index0 + 1], &items[index0], \
+                    (pv->num_items - index0) * sizeof(T)); \
+            items[index0] = *pitem; \
+            pv->num_items += 1U; \
+            vec2_mark_dirty(pv, index0, pv->num_items - index0); \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        else \
+        { \
+            /* status bad */ \
+            vec2_status_bad(pv); \
+        } \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN size_t name##_erase_key(PVEC2 pv, const T *key) \
+    { \
+        T *items = (T *)pv->items; \
+        size_t first, count; \
+        assert(vec2_valid(pv)); \
+        assert(pv->size_per_item == sizeof(T)); \
+        first = name##_equal_range(items, pv->num_items, key, &count); \
+        memmove(&items[first], &items[first + count], \
+                (pv->num_items - first - count) * sizeof(T)); \
+        pv->num_items -= count; \
+        if ((count > 0U) && (first < pv->num_items)) \
+        { \
+            vec2_mark_dirty(pv, first, pv->num_items - first); \
+        } \
+        return count; \
+    }
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_SORT_H */
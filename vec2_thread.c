@@ -0,0 +1,1164 @@
+/****************************************************************************/
+/* vec2_thread.c --- multi-threaded operations of vec2                      */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_THREAD_C
+#define KATAHIROMZ_VEC2_THREAD_C
+
+#ifndef _POSIX_C_SOURCE
+    #define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "vec2_thread.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+/****************************************************************************/
+/* status checking */
+
+#ifndef vec2_status_bad
+    #define vec2_status_bad(pv)    assert(0)
+#endif
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* thread team */
+
+/*
+ * NOTE: A team is the calling thread and the threads created for one
+ *       operation. The members share a barrier, because pthread_barrier_t
+ *       is optional in POSIX.
+ */
+struct VEC2_TEAM;
+typedef void (*VEC2_TEAM_FN)(struct VEC2_TEAM *team, size_t id);
+
+typedef struct VEC2_TEAM
+{
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+    size_t          num_threads;    /* zero until the team starts */
+    size_t          arrived;        /* number of threads at the barrier */
+    size_t          generation;     /* number of the barriers passed */
+    VEC2_TEAM_FN    fn;
+    void *          job;
+} VEC2_TEAM;
+
+typedef struct VEC2_TEAM_MEMBER
+{
+    VEC2_TEAM *     team;
+    size_t          id;
+} VEC2_TEAM_MEMBER;
+
+/* the number of the online processors */
+VEC2_INLINE_FN size_t vec2_thread_count(void)
+{
+#ifdef _SC_NPROCESSORS_ONLN
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (count > 0)
+    {
+        return (size_t)count;
+    }
+#endif
+    return 1;
+} /* vec2_thread_count */
+
+/* waits for all the members of the team */
+VEC2_INLINE_FN void vec2_team_wait(VEC2_TEAM *team)
+{
+    size_t generation;
+
+    pthread_mutex_lock(&team->mutex);
+    generation = team->generation;
+    if (++team->arrived == team->num_threads)
+    {
+        team->arrived = 0;
+        ++team->generation;
+        pthread_cond_broadcast(&team->cond);
+    }
+    else
+    {
+        while (generation == team->generation)
+        {
+            pthread_cond_wait(&team->cond, &team->mutex);
+        }
+    }
+    pthread_mutex_unlock(&team->mutex);
+} /* vec2_team_wait */
+
+static void *vec2_team_main(void *arg)
+{
+    VEC2_TEAM_MEMBER *member = (VEC2_TEAM_MEMBER *)arg;
+    VEC2_TEAM *team = member->team;
+
+    /* wait until the team size is fixed */
+    pthread_mutex_lock(&team->mutex);
+    while (team->num_threads == 0U)
+    {
+        pthread_cond_wait(&team->cond, &team->mutex);
+    }
+    pthread_mutex_unlock(&team->mutex);
+
+    (*team->fn)(team, member->id);
+    return NULL;
+} /* vec2_team_main */
+
+/* runs fn on nthreads threads at most, including the calling thread */
+VEC2_INLINE_FN void
+vec2_team_run(VEC2_TEAM_FN fn, void *job, size_t nthreads)
+{
+    VEC2_TEAM team;
+    VEC2_TEAM_MEMBER members[VEC2_THREAD_MAX];
+    pthread_t threads[VEC2_THREAD_MAX];
+    size_t i, num_threads;
+
+    assert(0 < nthreads && nthreads <= VEC2_THREAD_MAX);
+
+    team.num_threads = 0;
+    team.arrived = 0;
+    team.generation = 0;
+    team.fn = fn;
+    team.job = job;
+    if (nthreads == 1U)
+    {
+        team.num_threads = 1;
+        (*fn)(&team, 0);
+        return;
+    }
+
+    pthread_mutex_init(&team.mutex, NULL);
+    pthread_cond_init(&team.cond, NULL);
+
+    /* NOTE: If a thread cannot be created, the team gets smaller. */
+    for (num_threads = 1; num_threads < nthreads; ++num_threads)
+    {
+        members[num_threads].team = &team;
+        members[num_threads].id = num_threads;
+        if (pthread_create(&threads[num_threads], NULL, vec2_team_main,
+                           &members[num_threads]) != 0)
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_lock(&team.mutex);
+    team.num_threads = num_threads;
+    pthread_cond_broadcast(&team.cond);
+    pthread_mutex_unlock(&team.mutex);
+
+    (*fn)(&team, 0);
+
+    for (i = 1; i < num_threads; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_cond_destroy(&team.cond);
+    pthread_mutex_destroy(&team.mutex);
+} /* vec2_team_run */
+
+/****************************************************************************/
+/* parallel sort */
+
+/* the minimum number of items per thread */
+#ifndef VEC2_PARALLEL_GRAIN
+    #define VEC2_PARALLEL_GRAIN     4096
+#endif
+
+typedef struct VEC2_SORT_JOB
+{
+    char *                  items;
+    char *                  scratch;
+    size_t                  num_items;
+    size_t                  size_per_item;
+    VEC2_ITEM_COMPARE_FN    compare;    /* NULL if sorting by key */
+    size_t                  key_offset;
+    size_t                  key_size;
+    VEC2_KEY_TYPE           key_type;
+    size_t                  msb;        /* the offset of the top key byte */
+    size_t                  num_chunks;
+    size_t                  bounds[VEC2_THREAD_MAX + 1];
+} VEC2_SORT_JOB;
+
+/* the i-th significant byte of the key, in the order of vec2_sort_by_key() */
+VEC2_INLINE_FN unsigned int
+vec2_key_digit(const VEC2_SORT_JOB *job, const unsigned char *q, size_t i)
+{
+    unsigned int digit;
+
+    if (job->msb == job->key_offset)
+    {
+        digit = q[job->key_offset + i];
+    }
+    else
+    {
+        digit = q[job->msb - i];
+    }
+
+    if ((job->key_type == VEC2_KEY_FLOAT) && (q[job->msb] & 0x80))
+    {
+        /* negative: flip all the bits */
+        digit ^= 0xFF;
+    }
+    else if ((i == 0U) && (job->key_type != VEC2_KEY_UNSIGNED))
+    {
+        /* flip the sign bit */
+        digit ^= 0x80;
+    }
+    return digit;
+} /* vec2_key_digit */
+
+VEC2_INLINE_FN int
+vec2_sort_compare(const VEC2_SORT_JOB *job, const char *a, const char *b)
+{
+    size_t i;
+    unsigned int x, y;
+
+    if (job->compare != NULL)
+    {
+        return (*job->compare)(a, b);
+    }
+
+    if (job->key_type == VEC2_KEY_BYTES)
+    {
+        return memcmp(&a[job->key_offset], &b[job->key_offset],
+                      job->key_size);
+    }
+
+    for (i = 0; i < job->key_size; ++i)
+    {
+        x = vec2_key_digit(job, (const unsigned char *)a, i);
+        y = vec2_key_digit(job, (const unsigned char *)b, i);
+        if (x != y)
+        {
+            return (x < y) ? -1 : 1;
+        }
+    }
+    return 0;
+} /* vec2_sort_compare */
+
+/* the number of the items taken from a in the first k merged items */
+VEC2_INLINE_FN size_t
+vec2_merge_path(const VEC2_SORT_JOB *job, const char *a, size_t na,
+                const char *b, size_t nb, size_t k)
+{
+    size_t spi = job->size_per_item;
+    size_t lo, hi, mid;
+
+    lo = (k > nb) ? k - nb : 0;
+    hi = (k < na) ? k : na;
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        /* a wins ties to keep it stable */
+        if (vec2_sort_compare(job, &a[mid * spi],
+                              &b[(k - 1 - mid) * spi]) <= 0)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+} /* vec2_merge_path */
+
+/* merges the sorted runs a (na items) and b (nb items) into dest */
+VEC2_INLINE_FN void
+vec2_sort_merge(const VEC2_SORT_JOB *job, char *dest, const char *a,
+                size_t na, const char *b, size_t nb)
+{
+    size_t spi = job->size_per_item;
+    const char *a_end = a + na * spi;
+    const char *b_end = b + nb * spi;
+    const char *run;
+
+    while ((a != a_end) && (b != b_end))
+    {
+        /* copy the run of a that is not greater than *b at once */
+        run = a;
+        while ((a != a_end) && (vec2_sort_compare(job, a, b) <= 0))
+        {
+            a += spi;
+        }
+        memcpy(dest, run, (size_t)(a - run));
+        dest += a - run;
+        if (a == a_end)
+        {
+            break;
+        }
+
+        /* copy the run of b that is less than *a at once */
+        run = b;
+        while ((b != b_end) && (vec2_sort_compare(job, b, a) < 0))
+        {
+            b += spi;
+        }
+        memcpy(dest, run, (size_t)(b - run));
+        dest += b - run;
+    }
+    memcpy(dest, a, (size_t)(a_end - a));
+    dest += a_end - a;
+    memcpy(dest, b, (size_t)(b_end - b));
+} /* vec2_sort_merge */
+
+/* sorts the chunk t in place */
+VEC2_INLINE_FN void vec2_sort_chunk(const VEC2_SORT_JOB *job, size_t t)
+{
+    size_t spi = job->size_per_item;
+    size_t lo = job->bounds[t], count = job->bounds[t + 1] - lo;
+    VEC2 chunk, scratch;
+
+    /* untracked; the caller marks the whole vec2 dirty */
+    vec2_construct(&chunk, spi, count, &job->items[lo * spi], count);
+    vec2_construct(&scratch, spi, count, &job->scratch[lo * spi], count);
+
+    if (job->compare != NULL)
+    {
+        vec2_stable_sort(&chunk, job->compare, &scratch);
+    }
+    else
+    {
+        vec2_sort_by_key(&chunk, job->key_offset, job->key_size,
+                         job->key_type, &scratch);
+    }
+} /* vec2_sort_chunk */
+
+/*
+ * merges the part t of the output, where the runs are width chunks long.
+ * NOTE: The part t is the output range of the chunk t. It lies in one pair
+ *       of the runs, and the merge path gives its inputs.
+ */
+VEC2_INLINE_FN void
+vec2_sort_merge_part(const VEC2_SORT_JOB *job, const char *src, char *dest,
+                     size_t width, size_t t)
+{
+    size_t spi = job->size_per_item;
+    size_t first, mid, last, na, nb, k0, k1, i0, i1;
+    const char *a, *b;
+
+    first = t - t % (2 * width);
+    mid = first + width;
+    last = mid + width;
+    if (mid > job->num_chunks)
+    {
+        mid = job->num_chunks;
+    }
+    if (last > job->num_chunks)
+    {
+        last = job->num_chunks;
+    }
+
+    a = &src[job->bounds[first] * spi];
+    na = job->bounds[mid] - job->bounds[first];
+    b = &src[job->bounds[mid] * spi];
+    nb = job->bounds[last] - job->bounds[mid];
+
+    k0 = job->bounds[t] - job->bounds[first];
+    k1 = job->bounds[t + 1] - job->bounds[first];
+    i0 = vec2_merge_path(job, a, na, b, nb, k0);
+    i1 = vec2_merge_path(job, a, na, b, nb, k1);
+
+    vec2_sort_merge(job, &dest[job->bounds[t] * spi], &a[i0 * spi], i1 - i0,
+                    &b[(k0 - i0) * spi], (k1 - i1) - (k0 - i0));
+} /* vec2_sort_merge_part */
+
+static void vec2_sort_team(VEC2_TEAM *team, size_t id)
+{
+    const VEC2_SORT_JOB *job = (const VEC2_SORT_JOB *)team->job;
+    size_t spi = job->size_per_item;
+    size_t t, width;
+    char *src, *dest, *tmp;
+
+    for (t = id; t < job->num_chunks; t += team->num_threads)
+    {
+        vec2_sort_chunk(job, t);
+    }
+
+    /* merge the runs, ping-ponging between items and scratch */
+    src = job->items;
+    dest = job->scratch;
+    for (width = 1; width < job->num_chunks; width *= 2)
+    {
+        vec2_team_wait(team);
+        for (t = id; t < job->num_chunks; t += team->num_threads)
+        {
+            vec2_sort_merge_part(job, src, dest, width, t);
+        }
+        tmp = src;
+        src = dest;
+        dest = tmp;
+    }
+
+    if (src != job->items)
+    {
+        vec2_team_wait(team);
+        for (t = id; t < job->num_chunks; t += team->num_threads)
+        {
+            memcpy(&job->items[job->bounds[t] * spi],
+                   &src[job->bounds[t] * spi],
+                   (job->bounds[t + 1] - job->bounds[t]) * spi);
+        }
+    }
+} /* vec2_sort_team */
+
+VEC2_INLINE_FN void
+vec2_sort_run(VEC2_SORT_JOB *job, PVEC2 pv, PVEC2 scratch, size_t nthreads)
+{
+    size_t t, n = pv->num_items;
+
+    if (nthreads == 0U)
+    {
+        nthreads = vec2_thread_count();
+    }
+    if (nthreads > VEC2_THREAD_MAX)
+    {
+        nthreads = VEC2_THREAD_MAX;
+    }
+    if (nthreads > n / VEC2_PARALLEL_GRAIN)
+    {
+        nthreads = n / VEC2_PARALLEL_GRAIN;
+    }
+    if (nthreads == 0U)
+    {
+        nthreads = 1;
+    }
+
+    job->items = (char *)pv->items;
+    job->scratch = (char *)scratch->items;
+    job->num_items = n;
+    job->size_per_item = pv->size_per_item;
+    job->num_chunks = nthreads;
+    for (t = 0; t <= nthreads; ++t)
+    {
+        job->bounds[t] = (n / nthreads) * t;
+        job->bounds[t] += (t < n % nthreads) ? t : n % nthreads;
+    }
+
+    vec2_team_run(vec2_sort_team, job, nthreads);
+} /* vec2_sort_run */
+
+VEC2_API vec2_bool
+vec2_sort_parallel(PVEC2 pv, VEC2_ITEM_COMPARE_FN compare, PVEC2 scratch,
+                   size_t nthreads)
+{
+    VEC2_SORT_JOB job;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(pv));
+    assert(vec2_valid(scratch));
+    assert(compare != NULL);
+    assert(pv->items != scratch->items);
+
+    if (scratch->capacity * scratch->size_per_item <
+        pv->num_items * pv->size_per_item)
+    {
+        /* status bad */
+        vec2_status_bad(pv);
+    }
+    else
+    {
+        job.compare = compare;
+        job.key_offset = job.key_size = job.msb = 0;
+        job.key_type = VEC2_KEY_BYTES;
+        vec2_sort_run(&job, pv, scratch, nthreads);
+        vec2_mark_dirty(pv, 0, pv->num_items);
+        VEC2_STATUS_SET(ret, true);
+    }
+
+    assert(vec2_valid(pv));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_sort_parallel */
+
+VEC2_API vec2_bool
+vec2_sort_by_key_parallel(PVEC2 pv, size_t key_offset, size_t key_size,
+                          VEC2_KEY_TYPE key_type, PVEC2 scratch,
+                          size_t nthreads)
+{
+    VEC2_SORT_JOB job;
+    unsigned int one = 1;
+    VEC2_STATUS_INIT(ret, false);
+
+    assert(vec2_valid(pv));
+    assert(vec2_valid(scratch));
+    assert(key_size > 0U);
+    assert(key_offset + key_size <= pv->size_per_item);
+    assert((key_type != VEC2_KEY_FLOAT) || (key_size == 4U) ||
+           (key_size == 8U));
+    assert(pv->items != scratch->items);
+
+    if (scratch->capacity * scratch->size_per_item <
+        pv->num_items * pv->size_per_item)
+    {
+        /* status bad */
+        vec2_status_bad(pv);
+    }
+    else
+    {
+        job.compare = NULL;
+        job.key_offset = key_offset;
+        job.key_size = key_size;
+        job.key_type = key_type;
+        if ((key_type == VEC2_KEY_BYTES) || (*(unsigned char *)&one != 1))
+        {
+            job.msb = key_offset;
+        }
+        else
+        {
+            job.msb = key_offset + key_size - 1U;
+        }
+        vec2_sort_run(&job, pv, scratch, nthreads);
+        vec2_mark_dirty(pv, 0, pv->num_items);
+        VEC2_STATUS_SET(ret, true);
+    }
+
+    assert(vec2_valid(pv));
+    VEC2_STATUS_RETURN(ret);
+} /* vec2_sort_by_key_parallel */
+
+/****************************************************************************/
+/* worker pool */
+
+/* the number of the chunks per thread, for the load balancing */
+#ifndef VEC2_POOL_SPLIT
+    #define VEC2_POOL_SPLIT     16
+#endif
+
+typedef struct VEC2_POOL_JOB
+{
+    char *              items;
+    size_t              size_per_item;
+    VEC2_FOREACH_FN     fn;
+    size_t              index0;     /* the first item */
+    size_t              last;       /* the end of the items */
+    size_t              chunk;      /* the number of items per chunk */
+    size_t              first;      /* the first chunk */
+    VEC2_ATOMIC_SIZE    canceled;   /* polled between the items */
+} VEC2_POOL_JOB;
+
+/* takes a chunk of the worker id, or steals some chunks of the others */
+VEC2_INLINE_FN bool
+vec2_pool_take(VEC2_POOL *pool, size_t id, size_t *chunk)
+{
+    VEC2_POOL_DEQUE *deque = &pool->deques[id];
+    VEC2_POOL_DEQUE *victim;
+    size_t i, begin, end;
+    bool ret = false;
+
+    pthread_mutex_lock(&deque->mutex);
+    if (deque->next < deque->end)
+    {
+        *chunk = deque->next++;
+        ret = true;
+    }
+    pthread_mutex_unlock(&deque->mutex);
+
+    for (i = 1; !ret && (i < pool->num_threads); ++i)
+    {
+        /* steal the latter half */
+        victim = &pool->deques[(id + i) % pool->num_threads];
+        pthread_mutex_lock(&victim->mutex);
+        end = victim->end;
+        begin = end - (end - victim->next + 1) / 2;
+        if (begin < end)
+        {
+            victim->end = begin;
+            ret = true;
+        }
+        pthread_mutex_unlock(&victim->mutex);
+
+        if (ret)
+        {
+            *chunk = begin;
+            pthread_mutex_lock(&deque->mutex);
+            deque->next = begin + 1;
+            deque->end = end;
+            pthread_mutex_unlock(&deque->mutex);
+        }
+    }
+    return ret;
+} /* vec2_pool_take */
+
+/* stops all the threads */
+VEC2_INLINE_FN void vec2_pool_cancel(VEC2_POOL *pool, VEC2_POOL_JOB *job)
+{
+    size_t i;
+
+    VEC2_STORE_RELEASE(job->canceled, 1U);
+    for (i = 0; i < pool->num_threads; ++i)
+    {
+        pthread_mutex_lock(&pool->deques[i].mutex);
+        pool->deques[i].end = pool->deques[i].next;
+        pthread_mutex_unlock(&pool->deques[i].mutex);
+    }
+} /* vec2_pool_cancel */
+
+VEC2_INLINE_FN void vec2_pool_work(VEC2_POOL *pool, size_t id)
+{
+    VEC2_POOL_JOB *job = (VEC2_POOL_JOB *)pool->job;
+    size_t chunk, i, last;
+
+    while (vec2_pool_take(pool, id, &chunk))
+    {
+        i = chunk * job->chunk;
+        last = i + job->chunk;
+        if (i < job->index0)
+        {
+            i = job->index0;
+        }
+        if (last > job->last)
+        {
+            last = job->last;
+        }
+        for (; i < last; ++i)
+        {
+            if (VEC2_LOAD_RELAXED(job->canceled) != 0U)
+            {
+                return;
+            }
+            if ((*job->fn)(i, &job->items[i * job->size_per_item]) == false)
+            {
+                vec2_pool_cancel(pool, job);
+                return;
+            }
+        }
+    }
+} /* vec2_pool_work */
+
+static void *vec2_pool_main(void *arg)
+{
+    VEC2_POOL_DEQUE *deque = (VEC2_POOL_DEQUE *)arg;
+    VEC2_POOL *pool = deque->pool;
+    size_t generation = 0;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;)
+    {
+        while (!pool->quit && (generation == pool->generation))
+        {
+            pthread_cond_wait(&pool->start_cond, &pool->mutex);
+        }
+        if (pool->quit)
+        {
+            break;
+        }
+        generation = pool->generation;
+        pthread_mutex_unlock(&pool->mutex);
+
+        vec2_pool_work(pool, deque->id);
+
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->busy == 0U)
+        {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+    return NULL;
+} /* vec2_pool_main */
+
+VEC2_API void vec2_pool_construct(VEC2_POOL *pool, size_t nthreads)
+{
+    size_t i;
+
+    assert(pool != NULL);
+
+    if (nthreads == 0U)
+    {
+        nthreads = vec2_thread_count();
+    }
+    if (nthreads > VEC2_THREAD_MAX)
+    {
+        nthreads = VEC2_THREAD_MAX;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->start_cond, NULL);
+    pthread_cond_init(&pool->done_cond, NULL);
+    pool->generation = 0;
+    pool->busy = 0;
+    pool->quit = false;
+    pool->job = NULL;
+    for (i = 0; i < nthreads; ++i)
+    {
+        pthread_mutex_init(&pool->deques[i].mutex, NULL);
+        pool->deques[i].next = pool->deques[i].end = 0;
+        pool->deques[i].pool = pool;
+        pool->deques[i].id = i;
+    }
+
+    /* NOTE: If a thread cannot be created, the pool gets smaller. */
+    for (pool->num_threads = 1; pool->num_threads < nthreads;
+         ++pool->num_threads)
+    {
+        if (pthread_create(&pool->threads[pool->num_threads], NULL,
+                           vec2_pool_main,
+                           &pool->deques[pool->num_threads]) != 0)
+        {
+            break;
+        }
+    }
+    for (i = pool->num_threads; i < nthreads; ++i)
+    {
+        pthread_mutex_destroy(&pool->deques[i].mutex);
+    }
+} /* vec2_pool_construct */
+
+VEC2_API void vec2_pool_destroy(VEC2_POOL *pool)
+{
+    size_t i;
+
+    assert(pool != NULL);
+    assert(pool->busy == 0U);
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (i = 1; i < pool->num_threads; ++i)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+    for (i = 0; i < pool->num_threads; ++i)
+    {
+        pthread_mutex_destroy(&pool->deques[i].mutex);
+    }
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->start_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    pool->num_threads = 0;
+} /* vec2_pool_destroy */
+
+VEC2_API bool
+vec2_parallel_foreach(VEC2_POOL *pool, PVEC2 pv, VEC2_FOREACH_FN fn)
+{
+    assert(vec2_valid(pv));
+    return vec2_parallel_foreach_range(pool, pv, fn, 0, pv->num_items);
+} /* vec2_parallel_foreach */
+
+VEC2_API bool
+vec2_parallel_foreach_range(VEC2_POOL *pool, PVEC2 pv, VEC2_FOREACH_FN fn,
+                            size_t index0, size_t count)
+{
+    VEC2_POOL_JOB job;
+    size_t i, num_chunks, line, a, b, t;
+
+    assert(vec2_valid(pv));
+    assert(fn != NULL);
+    assert(index0 <= pv->num_items);
+    assert((index0 + count) <= pv->num_items);
+
+    job.items = (char *)pv->items;
+    job.size_per_item = pv->size_per_item;
+    job.fn = fn;
+    job.index0 = index0;
+    job.last = index0 + count;
+    VEC2_ATOMIC_INIT(job.canceled, 0U);
+
+    if ((pool == NULL) || (pool->num_threads <= 1U) || (count <= 1U))
+    {
+        for (i = index0; i < job.last; ++i)
+        {
+            if ((*fn)(i, &job.items[i * job.size_per_item]) == false)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /* the number of the items in a cache-line-aligned chunk */
+    a = VEC2_CACHE_LINE;
+    b = job.size_per_item;
+    while (b != 0U)
+    {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    line = VEC2_CACHE_LINE / a;
+
+    /* chunk k is [k * chunk, (k + 1) * chunk) clipped to the range */
+    job.chunk = count / (pool->num_threads * VEC2_POOL_SPLIT);
+    job.chunk = (job.chunk + line - 1) / line * line;
+    if (job.chunk == 0U)
+    {
+        job.chunk = line;
+    }
+    job.first = index0 / job.chunk;
+    num_chunks = (job.last - 1) / job.chunk + 1 - job.first;
+
+    /* deal the chunks to the threads */
+    for (i = 0; i < pool->num_threads; ++i)
+    {
+        pool->deques[i].next = job.first + num_chunks * i / pool->num_threads;
+        pool->deques[i].end =
+            job.first + num_chunks * (i + 1) / pool->num_threads;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    assert(pool->busy == 0U);
+    pool->job = &job;
+    pool->busy = pool->num_threads - 1;
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->start_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    vec2_pool_work(pool, 0);
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->busy > 0U)
+    {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+    pool->job = NULL;
+    pthread_mutex_unlock(&pool->mutex);
+
+    return VEC2_LOAD_ACQUIRE(job.canceled) == 0U;
+} /* vec2_parallel_foreach_range */
+
+/****************************************************************************/
+/* concurrent append */
+
+VEC2_API void vec2_shared_construct(VEC2_SHARED *ps, PVEC2 pv)
+{
+    assert(ps != NULL);
+    assert(vec2_valid(pv));
+
+    ps->pv = pv;
+    VEC2_ATOMIC_INIT(ps->reserved, pv->num_items);
+    VEC2_ATOMIC_INIT(ps->committed, pv->num_items);
+} /* vec2_shared_construct */
+
+VEC2_API size_t
+vec2_shared_reserve(VEC2_SHARED *ps, size_t count, size_t *pfirst)
+{
+    size_t first, capacity;
+
+    assert(ps != NULL);
+    assert(pfirst != NULL);
+
+    /* one atomic addition reserves the whole range */
+    first = VEC2_FETCH_ADD_RELAXED(ps->reserved, count);
+    capacity = ps->pv->capacity;
+    *pfirst = first;
+    if (first >= capacity)
+    {
+        return 0;
+    }
+    if (count > capacity - first)
+    {
+        /* the rest of the range is beyond the block */
+        count = capacity - first;
+    }
+    return count;
+} /* vec2_shared_reserve */
+
+VEC2_API void
+vec2_shared_commit(VEC2_SHARED *ps, size_t first, size_t count)
+{
+    assert(ps != NULL);
+
+    if (count == 0U)
+    {
+        return;
+    }
+
+    /* wait for the writers of the earlier ranges */
+    while (VEC2_LOAD_ACQUIRE(ps->committed) != first)
+    {
+        sched_yield();
+    }
+    VEC2_STORE_RELEASE(ps->committed, first + count);
+} /* vec2_shared_commit */
+
+VEC2_API size_t
+vec2_shared_append(VEC2_SHARED *ps, const void *items, size_t count)
+{
+    size_t first, size_per_item;
+
+    assert(ps != NULL);
+    assert((items != NULL) || (count == 0U));
+
+    count = vec2_shared_reserve(ps, count, &first);
+    if (count > 0U)
+    {
+        size_per_item = ps->pv->size_per_item;
+        memcpy((char *)ps->pv->items + first * size_per_item, items,
+               count * size_per_item);
+        vec2_shared_commit(ps, first, count);
+    }
+    return count;
+} /* vec2_shared_append */
+
+VEC2_API bool vec2_shared_push_back(VEC2_SHARED *ps, const void *pitem)
+{
+    return vec2_shared_append(ps, pitem, 1) == 1U;
+} /* vec2_shared_push_back */
+
+VEC2_API size_t vec2_shared_size(VEC2_SHARED *ps)
+{
+    assert(ps != NULL);
+    return VEC2_LOAD_ACQUIRE(ps->committed);
+} /* vec2_shared_size */
+
+VEC2_API void vec2_shared_finish(VEC2_SHARED *ps)
+{
+    size_t committed;
+
+    assert(ps != NULL);
+    committed = VEC2_LOAD_ACQUIRE(ps->committed);
+    vec2_mark_dirty(ps->pv, ps->pv->num_items,
+                    committed - ps->pv->num_items);
+    ps->pv->num_items = committed;
+    assert(vec2_valid(ps->pv));
+} /* vec2_shared_finish */
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* testing */
+
+/* #define VEC2_THREAD_TEST */
+
+#ifdef VEC2_THREAD_TEST
+    #include <stdio.h>
+    #include <stddef.h>
+
+    typedef struct RECORD
+    {
+        int     key;
+        double  value;
+        size_t  order;
+    } RECORD;
+
+    int record_compare(const void *x, const void *y)
+    {
+        const RECORD *a = (const RECORD *)x;
+        const RECORD *b = (const RECORD *)y;
+        if (a->key < b->key)
+        {
+            return -1;
+        }
+        if (a->key > b->key)
+        {
+            return 1;
+        }
+        return 0;
+    }
+
+    bool double_foreach(size_t index0, void *pitem)
+    {
+        (void)index0;
+        *(long *)pitem *= 2;
+        return true;
+    }
+
+    bool cancel_foreach(size_t index0, void *pitem)
+    {
+        *(long *)pitem = -1;
+        return index0 != 5000;
+    }
+
+    #define NUM_WRITERS     4
+    #define NUM_PER_WRITER  30000     /* more than the block */
+
+    typedef struct WRITER
+    {
+        VEC2_SHARED *   shared;
+        long            id;
+    } WRITER;
+
+    /* push_back and the batches of 1..7 items in turn */
+    void *writer_main(void *arg)
+    {
+        WRITER *writer = (WRITER *)arg;
+        long batch[8], next = 0, i, n;
+        size_t added;
+
+        while (next < NUM_PER_WRITER)
+        {
+            n = (next % 2 == 0) ? 1 : next % 7 + 1;
+            if (n > NUM_PER_WRITER - next)
+            {
+                n = NUM_PER_WRITER - next;
+            }
+            for (i = 0; i < n; ++i)
+            {
+                batch[i] = writer->id * NUM_PER_WRITER + next + i + 1;
+            }
+            if (n == 1)
+            {
+                added = vec2_shared_push_back(writer->shared, batch) ? 1 : 0;
+            }
+            else
+            {
+                added = vec2_shared_append(writer->shared, batch, (size_t)n);
+            }
+            if (added == 0)
+            {
+                break;
+            }
+            next += (long)added;
+        }
+        return NULL;
+    }
+
+    #define NUM_RECORDS     100000
+
+    static RECORD s_source[NUM_RECORDS];
+    static RECORD s_items[NUM_RECORDS];
+    static RECORD s_expected[NUM_RECORDS];
+    static RECORD s_scratch[NUM_RECORDS];
+    static long s_longs[NUM_RECORDS];
+
+    int main(void)
+    {
+        VEC2 vec, expected, scratch;
+        VEC2_POOL pool;
+        VEC2_SHARED shared;
+        WRITER writers[NUM_WRITERS];
+        pthread_t threads[NUM_WRITERS];
+        size_t counts[NUM_WRITERS], seen, size;
+        long value;
+        size_t i, nthreads;
+        unsigned long seed = 12345;
+        bool ok;
+
+        for (i = 0; i < NUM_RECORDS; ++i)
+        {
+            seed = seed * 1103515245UL + 12345UL;
+            s_source[i].key = (int)((seed >> 16) % 1000U) - 500;
+            s_source[i].value = (double)(int)((seed >> 8) % 2000U) - 1000.0;
+            s_source[i].order = i;
+        }
+
+        vec2_construct(&vec, sizeof(RECORD), NUM_RECORDS, s_items, 0);
+        vec2_construct(&expected, sizeof(RECORD), NUM_RECORDS, s_expected, 0);
+        vec2_construct(&scratch, sizeof(RECORD), NUM_RECORDS, s_scratch, 0);
+        vec.num_items = expected.num_items = NUM_RECORDS;
+
+        /* the same result as the serial sorts, whatever the threads are */
+        for (nthreads = 0; nthreads <= 9; ++nthreads)
+        {
+            memcpy(s_expected, s_source, sizeof(s_source));
+            vec2_stable_sort(&expected, record_compare, &scratch);
+            memcpy(s_items, s_source, sizeof(s_source));
+            vec2_sort_parallel(&vec, record_compare, &scratch, nthreads);
+            ok = (memcmp(s_items, s_expected, sizeof(s_items)) == 0);
+            assert(ok);
+
+            memcpy(s_expected, s_source, sizeof(s_source));
+            vec2_sort_by_key(&expected, offsetof(RECORD, value),
+                             sizeof(double), VEC2_KEY_FLOAT, &scratch);
+            memcpy(s_items, s_source, sizeof(s_source));
+            vec2_sort_by_key_parallel(&vec, offsetof(RECORD, value),
+                                      sizeof(double), VEC2_KEY_FLOAT,
+                                      &scratch, nthreads);
+            ok = (memcmp(s_items, s_expected, sizeof(s_items)) == 0);
+            assert(ok);
+
+            memcpy(s_expected, s_source, sizeof(s_source));
+            vec2_sort_by_key(&expected, offsetof(RECORD, key),
+                             sizeof(int), VEC2_KEY_SIGNED, &scratch);
+            memcpy(s_items, s_source, sizeof(s_source));
+            vec2_sort_by_key_parallel(&vec, offsetof(RECORD, key),
+                                      sizeof(int), VEC2_KEY_SIGNED,
+                                      &scratch, nthreads);
+            ok = (memcmp(s_items, s_expected, sizeof(s_items)) == 0);
+            assert(ok);
+        }
+        printf("vec2_sort_parallel: ok\n");
+
+        vec2_construct(&vec, sizeof(long), NUM_RECORDS, s_longs, 0);
+        vec.num_items = NUM_RECORDS;
+        for (nthreads = 0; nthreads <= 5; ++nthreads)
+        {
+            vec2_pool_construct(&pool, nthreads);
+            for (i = 0; i < NUM_RECORDS; ++i)
+            {
+                s_longs[i] = (long)i;
+            }
+            ok = vec2_parallel_foreach(&pool, &vec, double_foreach);
+            assert(ok);
+            ok = vec2_parallel_foreach_range(&pool, &vec, double_foreach,
+                                             3, 77777);
+            assert(ok);
+            for (i = 0; i < NUM_RECORDS; ++i)
+            {
+                ok = (s_longs[i] ==
+                      (long)i * ((3 <= i && i < 3 + 77777) ? 4 : 2));
+                assert(ok);
+            }
+
+            ok = vec2_parallel_foreach(&pool, &vec, cancel_foreach);
+            assert(!ok);
+            ok = (s_longs[5000] == -1);
+            assert(ok);
+            vec2_pool_destroy(&pool);
+        }
+        printf("vec2_parallel_foreach: ok\n");
+
+        /* the readers see the written items only */
+        memset(s_longs, 0, sizeof(s_longs));
+        vec2_construct(&vec, sizeof(long), NUM_RECORDS, s_longs, 0);
+        vec2_shared_construct(&shared, &vec);
+        for (i = 0; i < NUM_WRITERS; ++i)
+        {
+            writers[i].shared = &shared;
+            writers[i].id = (long)i;
+            pthread_create(&threads[i], NULL, writer_main, &writers[i]);
+        }
+        seen = 0;
+        while (seen < NUM_RECORDS)
+        {
+            size = vec2_shared_size(&shared);
+            for (; seen < size; ++seen)
+            {
+                ok = (s_longs[seen] != 0);
+                assert(ok);
+            }
+            sched_yield();
+        }
+        for (i = 0; i < NUM_WRITERS; ++i)
+        {
+            pthread_join(threads[i], NULL);
+        }
+        vec2_shared_finish(&shared);
+        ok = (vec2_size(&vec) == NUM_RECORDS);
+        assert(ok);
+
+        /* each writer's values once, in order, until the block got full */
+        memset(counts, 0, sizeof(counts));
+        for (i = 0; i < NUM_RECORDS; ++i)
+        {
+            value = s_longs[i] - 1;
+            ok = (0 <= value && value < NUM_WRITERS * NUM_PER_WRITER);
+            assert(ok);
+            ok = ((size_t)(value % NUM_PER_WRITER) ==
+                  counts[value / NUM_PER_WRITER]);
+            assert(ok);
+            ++counts[value / NUM_PER_WRITER];
+        }
+        printf("vec2_shared_append: ok\n");
+
+        return 0;
+    } /* main */
+#endif  /* def VEC2_THREAD_TEST */
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_THREAD_C */
@@ -0,0 +1,170 @@
+/****************************************************************************/
+/* vec2_thread.h --- multi-threaded operations of vec2                      */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_THREAD_H
+#define KATAHIROMZ_VEC2_THREAD_H
+
+#include "vec2.h"
+#include "vec2_queue.h"     /* for the atomics */
+#include <pthread.h>
+
+/*
+ * NOTE: vec2_thread.c uses POSIX threads. Build it with -pthread.
+ *       The functions don't allocate memory. The number of threads is
+ *       limited to VEC2_THREAD_MAX. If nthreads is zero, the number of the
+ *       online processors is used.
+ */
+#ifndef VEC2_THREAD_MAX
+    #define VEC2_THREAD_MAX     64
+#endif
+
+/* the size of a cache line */
+#ifndef VEC2_CACHE_LINE
+    #define VEC2_CACHE_LINE     64
+#endif
+
+/****************************************************************************/
+/* types */
+
+/* the chunks of one worker. others steal from the end. */
+typedef struct VEC2_POOL_DEQUE
+{
+    pthread_mutex_t     mutex;
+    size_t              next;       /* the next chunk to run */
+    size_t              end;        /* the end of the chunks */
+    struct VEC2_POOL *  pool;
+    size_t              id;
+    char                pad[VEC2_CACHE_LINE];   /* against false sharing */
+} VEC2_POOL_DEQUE;
+
+/*
+ * VEC2_POOL is a reusable worker pool for vec2_parallel_foreach().
+ * NOTE: The caller of vec2_parallel_foreach() works as one of the threads.
+ *       A pool runs one operation at a time.
+ */
+typedef struct VEC2_POOL
+{
+    pthread_mutex_t     mutex;
+    pthread_cond_t      start_cond;     /* signals a new job or quitting */
+    pthread_cond_t      done_cond;      /* signals the end of the job */
+    size_t              num_threads;    /* the workers and the caller */
+    size_t              generation;     /* the number of the jobs started */
+    size_t              busy;           /* the workers running the job */
+    bool                quit;
+    void *              job;
+    pthread_t           threads[VEC2_THREAD_MAX];
+    VEC2_POOL_DEQUE     deques[VEC2_THREAD_MAX];
+} VEC2_POOL;
+
+/*
+ * VEC2_SHARED lets threads append to one vec2 without a mutex. A writer
+ * reserves a range of slots by one atomic addition to reserved, copies its
+ * items there, and commits the range. The commits advance committed in
+ * the order of the ranges, so [0, committed) is always written completely.
+ * NOTE: It's not lock-free. A commit spins (with sched_yield) until all
+ *       the earlier ranges are committed, so a stalled writer blocks the
+ *       commits of all the later writers and the items readers can see.
+ */
+typedef struct VEC2_SHARED
+{
+    PVEC2               pv;
+    char                pad0[VEC2_CACHE_LINE];
+    VEC2_ATOMIC_SIZE    reserved;       /* the slots reserved by writers */
+    char                pad1[VEC2_CACHE_LINE];
+    VEC2_ATOMIC_SIZE    committed;      /* the slots written completely */
+    char                pad2[VEC2_CACHE_LINE];
+} VEC2_SHARED;
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************/
+/* functions */
+
+/*
+ * parallel sort
+ * NOTE: vec2_sort_parallel() and vec2_sort_by_key_parallel() sort the
+ *       chunks of the items on the threads and then merge them in parallel
+ *       through scratch. The result is identical to vec2_stable_sort() and
+ *       vec2_sort_by_key(), whatever nthreads is. scratch is a fixed block
+ *       of the same item size that can hold all the items.
+ */
+VEC2_API vec2_bool
+vec2_sort_parallel(PVEC2 pv, VEC2_ITEM_COMPARE_FN compare, PVEC2 scratch,
+                   size_t nthreads);
+VEC2_API vec2_bool
+vec2_sort_by_key_parallel(PVEC2 pv, size_t key_offset, size_t key_size,
+                          VEC2_KEY_TYPE key_type, PVEC2 scratch,
+                          size_t nthreads);
+
+/*
+ * worker pool
+ * NOTE: vec2_pool_construct() starts nthreads - 1 workers. It may start
+ *       fewer if the system cannot create them.
+ */
+VEC2_API void vec2_pool_construct(VEC2_POOL *pool, size_t nthreads);
+VEC2_API void vec2_pool_destroy(VEC2_POOL *pool);
+
+/*
+ * parallel foreach
+ * NOTE: vec2_parallel_foreach() splits the items into chunks of whole cache
+ *       lines (if the fixed block is aligned to a cache line) and runs them
+ *       on the pool. Idle threads steal the chunks of the busy ones. The
+ *       items are visited in no particular order. If fn returns false, the
+ *       other threads stop after the item they are visiting, and the
+ *       function returns false. If pool is NULL, it runs serially.
+ */
+VEC2_API bool
+vec2_parallel_foreach(VEC2_POOL *pool, PVEC2 pv, VEC2_FOREACH_FN fn);
+VEC2_API bool
+vec2_parallel_foreach_range(VEC2_POOL *pool, PVEC2 pv, VEC2_FOREACH_FN fn,
+                            size_t index0, size_t count);
+
+/*
+ * concurrent append
+ * NOTE: vec2_shared_reserve() reserves count slots at most from *pfirst and
+ *       returns the number reserved. It is less than count if the fixed
+ *       block gets full. The writer must commit the reserved slots by
+ *       vec2_shared_commit(), which blocks until the earlier ranges are
+ *       committed (in the order of the reservations). A thread holding
+ *       two ranges must commit them in the order reserved, or it waits
+ *       for itself forever.
+ *       vec2_shared_append() and vec2_shared_push_back() do all of
+ *       them. vec2_shared_size() returns the number of the items that
+ *       readers can see. vec2_shared_finish() stores it to pv->num_items
+ *       after all the writers finish.
+ */
+VEC2_API void vec2_shared_construct(VEC2_SHARED *ps, PVEC2 pv);
+VEC2_API size_t
+vec2_shared_reserve(VEC2_SHARED *ps, size_t count, size_t *pfirst);
+VEC2_API void
+vec2_shared_commit(VEC2_SHARED *ps, size_t first, size_t count);
+VEC2_API size_t
+vec2_shared_append(VEC2_SHARED *ps, const void *items, size_t count);
+VEC2_API bool vec2_shared_push_back(VEC2_SHARED *ps, const void *pitem);
+VEC2_API size_t vec2_shared_size(VEC2_SHARED *ps);
+VEC2_API void vec2_shared_finish(VEC2_SHARED *ps);
+
+/****************************************************************************/
+/* C/C++ switching */
+
+#ifdef __cplusplus
+} /* extern "C" */
+#endif
+
+/****************************************************************************/
+/* header-only build */
+
+#ifdef VEC2_INLINE
+    #include "vec2_thread.c"
+#endif
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_THREAD_H */
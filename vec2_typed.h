@@ -0,0 +1,662 @@
+/****************************************************************************/
+/* vec2_typed.h --- type-specialized vec2 (fixed block vector for C)        */
+/****************************************************************************/
+
+#ifndef KATAHIROMZ_VEC2_TYPED_H
+#define KATAHIROMZ_VEC2_TYPED_H    0  /* Version 0 */
+
+#include "vec2.h"
+
+/*
+ * VEC2_DECLARE(name, T) generates the fixed block vector type "name" of
+ * items of type T, and the inline functions name##_construct(),
+ * name##_push_back(), ... that mirror the vec2.h API.
+ *
+ * The item size is sizeof(T), a compile-time constant. An item copy is
+ * a structure assignment, so the compiler can emit plain stores instead of
+ * calling memcpy with a runtime length.
+ *
+ *     VEC2_DECLARE(LONGVEC, long)
+ *
+ *     static long items[100];
+ *     LONGVEC v;
+ *     long n = 1;
+ *     LONGVEC_construct(&v, 100, items, 0);
+ *     LONGVEC_push_back(&v, &n);
+ *
+ * NOTE: vec2_data(), vec2_empty(), vec2_size() and vec2_capacity() can be
+ *       used for the typed vector as well.
+ *       The typed vectors have no dirty bitmap. VEC2_DIRTY_TRACKING doesn't
+ *       track their changes.
+ */
+
+/****************************************************************************/
+/* helper macros */
+
+#ifndef vec2_status_bad
+    #define vec2_status_bad(pv)    assert(0)
+#endif
+
+#ifdef VEC2_QUICK_BUT_RISKY
+    #define VEC2_IF_STATUS_(expr)  expr;
+#else
+    #define VEC2_IF_STATUS_(expr)  if (expr)
+#endif
+
+#ifdef VEC2_NO_ZERO_INIT
+    #define VEC2_ZERO_FILL_(ptr,size)  /* empty */
+#else
+    #define VEC2_ZERO_FILL_(ptr,size)  memset((ptr), 0, (size))
+#endif
+
+/****************************************************************************/
+/* type */
+
+#define VEC2_DECLARE_TYPE_(name,T) \
+    typedef struct name \
+    { \
+        T *     items;          /* Not malloc'ed. It's a fixed block. */ \
+        size_t  num_items;      /* number of items alive */ \
+        size_t  capacity;       /* number of items allocated */ \
+    } name, *P##name; \
+    \
+    /* NOTE: name##_FOREACH_FN returns false to cancel operation. */ \
+    typedef bool (*name##_FOREACH_FN)(size_t index0, T *pitem); \
+    \
+    /* NOTE: name##_BATCH_FN returns false to cancel operation. */ \
+    typedef bool (*name##_BATCH_FN)(size_t index0, T *pitems, size_t count); \
+    \
+    /* NOTE: name##_PREDICATE_FN returns true to choose the item. */ \
+    typedef bool (*name##_PREDICATE_FN)(size_t index0, const T *pitem);
+
+/****************************************************************************/
+/* basic functions */
+
+#define VEC2_DECLARE_BASIC_(name,T) \
+    VEC2_INLINE_FN bool name##_valid(const name *pv) \
+    { \
+        bool ret; \
+        if ((pv == NULL) || (pv->num_items > pv->capacity)) \
+        { \
+            ret = false; \
+        } \
+        else if ((pv->num_items != 0U) && (pv->items == NULL)) \
+        { \
+            ret = false; \
+        } \
+        else \
+        { \
+            ret = true; \
+        } \
+        return ret; \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool \
+    name##_construct(name *pv, size_t capacity, T *items, size_t num_items) \
+    { \
+        VEC2_STATUS_INIT(ret, true); \
+        assert(items != NULL); \
+        pv->items = items; \
+        pv->num_items = num_items; \
+        pv->capacity = capacity; \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN void name##_destroy(name *pv) \
+    { \
+        assert(name##_valid(pv)); \
+        (void)pv; \
+    } \
+    \
+    VEC2_INLINE_FN void name##_clear(name *pv) \
+    { \
+        assert(name##_valid(pv)); \
+        pv->num_items = 0; \
+    } \
+    \
+    VEC2_INLINE_FN T *name##_item(name *pv, size_t index0) \
+    { \
+        assert(name##_valid(pv)); \
+        assert(index0 <= pv->num_items); \
+        return &pv->items[index0]; \
+    } \
+    \
+    VEC2_INLINE_FN const T *name##_const_item(const name *pv, size_t index0) \
+    { \
+        assert(name##_valid(pv)); \
+        assert(index0 <= pv->num_items); \
+        return &pv->items[index0]; \
+    } \
+    \
+    VEC2_INLINE_FN T *name##_front(name *pv) \
+    { \
+        return pv->items; \
+    } \
+    \
+    VEC2_INLINE_FN T *name##_back(name *pv) \
+    { \
+        return name##_item(pv, pv->num_items - 1); \
+    } \
+    \
+    VEC2_INLINE_FN T *name##_get_at(name *pv, size_t index0) \
+    { \
+        T *p = NULL; \
+        assert(name##_valid(pv)); \
+        assert(index0 <= pv->num_items); \
+        if (index0 <= pv->num_items) \
+        { \
+            p = &pv->items[index0]; \
+        } \
+        return p; \
+    } \
+    \
+    VEC2_INLINE_FN void name##_set_at(name *pv, size_t index0, const T *pitem) \
+    { \
+        T *p; \
+        assert(name##_valid(pv)); \
+        p = name##_get_at(pv, index0); \
+        if (p != NULL) \
+        { \
+            *p = *pitem; \
+        } \
+        assert(name##_valid(pv)); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool name##_reserve(name *pv, size_t capacity) \
+    { \
+        VEC2_STATUS_INIT(ret, true); \
+        assert(name##_valid(pv)); \
+        if (capacity > pv->capacity) \
+        { \
+            VEC2_STATUS_SET(ret, false); \
+            /* status bad */ \
+            vec2_status_bad(pv); \
+        } \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN void name##_shrink_to_fit(name *pv) \
+    { \
+        /* does nothing */ \
+        assert(name##_valid(pv)); \
+        (void)pv; \
+    } \
+    \
+    VEC2_INLINE_FN void name##_swap(name *pv1, name *pv2) \
+    { \
+        name v; \
+        assert(name##_valid(pv1)); \
+        assert(name##_valid(pv2)); \
+        if (pv1 != pv2) \
+        { \
+            v = *pv1; \
+            *pv1 = *pv2; \
+            *pv2 = v; \
+        } \
+    }
+
+/****************************************************************************/
+/* adding and removing */
+
+#define VEC2_DECLARE_MODIFY_(name,T) \
+    VEC2_INLINE_FN vec2_bool name##_push_back(name *pv, const T *pitem) \
+    { \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        assert(pitem); \
+        VEC2_IF_STATUS_(name##_reserve(pv, pv->num_items + 1U)) \
+        { \
+            pv->items[pv->num_items] = *pitem; \
+            pv->num_items += 1U; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN size_t \
+    name##_append(name *pv, const T *items, size_t count) \
+    { \
+        assert(name##_valid(pv)); \
+        if (count > pv->capacity - pv->num_items) \
+        { \
+            count = pv->capacity - pv->num_items; \
+        } \
+        if (count > 0U) \
+        { \
+            memcpy(&pv->items[pv->num_items], items, count * sizeof(T)); \
+            pv->num_items += count; \
+        } \
+        return count; \
+    } \
+    \
+    VEC2_INLINE_FN size_t \
+    name##_push_back_n(name *pv, size_t count, const T *pitem) \
+    { \
+        size_t i; \
+        T *p; \
+        assert(name##_valid(pv)); \
+        if (count > pv->capacity - pv->num_items) \
+        { \
+            count = pv->capacity - pv->num_items; \
+        } \
+        p = &pv->items[pv->num_items]; \
+        if (pitem != NULL) \
+        { \
+            for (i = 0; i < count; ++i) \
+            { \
+                p[i] = *pitem; \
+            } \
+        } \
+        else \
+        { \
+            VEC2_ZERO_FILL_(p, count * sizeof(T)); \
+        } \
+        pv->num_items += count; \
+        return count; \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool name##_pop_back(name *pv) \
+    { \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        if (pv->num_items > 0U) \
+        { \
+            pv->num_items -= 1U; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool name##_copy(name *dest, const name *src) \
+    { \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(dest)); \
+        assert(name##_valid(src)); \
+        if (dest != src) \
+        { \
+            assert(dest->items != src->items); \
+            VEC2_IF_STATUS_(name##_reserve(dest, src->num_items)) \
+            { \
+                memcpy(dest->items, src->items, src->num_items * sizeof(T)); \
+                dest->num_items = src->num_items; \
+                VEC2_STATUS_SET(ret, true); \
+            } \
+        } \
+        assert(name##_valid(dest)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool \
+    name##_resize(name *pv, size_t count, const T *pitem) \
+    { \
+        size_t i, old_num_items = pv->num_items; \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        VEC2_IF_STATUS_(name##_reserve(pv, count)) \
+        { \
+            if (count > old_num_items) \
+            { \
+                if (pitem != NULL) \
+                { \
+                    for (i = old_num_items; i < count; ++i) \
+                    { \
+                        pv->items[i] = *pitem; \
+                    } \
+                } \
+                else \
+                { \
+                    VEC2_ZERO_FILL_(&pv->items[old_num_items], \
+                                    (count - old_num_items) * sizeof(T)); \
+                } \
+            } \
+            pv->num_items = count; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool \
+    name##_assign(name *pv, size_t count, const T *pitem) \
+    { \
+        size_t i; \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        VEC2_IF_STATUS_(name##_reserve(pv, count)) \
+        { \
+            if (pitem != NULL) \
+            { \
+                for (i = 0; i < count; ++i) \
+                { \
+                    pv->items[i] = *pitem; \
+                } \
+            } \
+            else \
+            { \
+                VEC2_ZERO_FILL_(pv->items, count * sizeof(T)); \
+            } \
+            pv->num_items = count; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool \
+    name##_insert(name *pv, size_t index0, size_t count, const T *pitem) \
+    { \
+        size_t i; \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        assert(index0 <= pv->num_items); \
+        VEC2_IF_STATUS_(name##_reserve(pv, pv->num_items + count)) \
+        { \
+            memmove(&pv->items[index0 + count], &pv->items[index0], \
+                    (pv->num_items - index0) * sizeof(T)); \
+            for (i = index0; i < index0 + count; ++i) \
+            { \
+                pv->items[i] = *pitem; \
+            } \
+            pv->num_items += count; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool \
+    name##_insert_sub(name *pv, size_t index0, const name *psubvec) \
+    { \
+        size_t count = psubvec->num_items; \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        assert(name##_valid(psubvec)); \
+        assert(index0 <= pv->num_items); \
+        VEC2_IF_STATUS_(name##_reserve(pv, pv->num_items + count)) \
+        { \
+            memmove(&pv->items[index0 + count], &pv->items[index0], \
+                    (pv->num_items - index0) * sizeof(T)); \
+            memcpy(&pv->items[index0], psubvec->items, count * sizeof(T)); \
+            pv->num_items += count; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool name##_erase(name *pv, size_t index0) \
+    { \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        assert(index0 < pv->num_items); \
+        if (index0 < pv->num_items) \
+        { \
+            memmove(&pv->items[index0], &pv->items[index0 + 1], \
+                    ((pv->num_items - index0) - 1U) * sizeof(T)); \
+            pv->num_items -= 1U; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool \
+    name##_erase_range(name *pv, size_t index0, size_t count) \
+    { \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        assert(index0 < pv->num_items); \
+        assert((index0 + count) <= pv->num_items); \
+        if ((count != 0U) && ((index0 + count) <= pv->num_items)) \
+        { \
+            memmove(&pv->items[index0], &pv->items[index0 + count], \
+                    ((pv->num_items - index0) - count) * sizeof(T)); \
+            pv->num_items -= count; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool name##_erase_unordered(name *pv, size_t index0) \
+    { \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        assert(index0 < pv->num_items); \
+        if (index0 < pv->num_items) \
+        { \
+            pv->num_items -= 1U; \
+            pv->items[index0] = pv->items[pv->num_items]; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool \
+    name##_erase_range_unordered(name *pv, size_t index0, size_t count) \
+    { \
+        size_t moved; \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        assert(index0 < pv->num_items); \
+        assert((index0 + count) <= pv->num_items); \
+        if ((count != 0U) && ((index0 + count) <= pv->num_items)) \
+        { \
+            moved = pv->num_items - (index0 + count); \
+            moved = (moved < count) ? moved : count; \
+            memcpy(&pv->items[index0], &pv->items[pv->num_items - moved], \
+                   moved * sizeof(T)); \
+            pv->num_items -= count; \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    } \
+    \
+    VEC2_INLINE_FN size_t \
+    name##_erase_if(name *pv, name##_PREDICATE_FN pred) \
+    { \
+        size_t i, n, run, dest; \
+        bool kept; \
+        assert(name##_valid(pv)); \
+        assert(pred != NULL); \
+        n = pv->num_items; \
+        dest = i = 0; \
+        kept = false; \
+        while (i < n) \
+        { \
+            /* pred is called once per item, as vec2_erase_if() */ \
+            run = i; \
+            if (kept) \
+            { \
+                ++i; \
+            } \
+            while ((i < n) && !(*pred)(i, &pv->items[i])) \
+            { \
+                ++i; \
+            } \
+            if (run != dest) \
+            { \
+                memmove(&pv->items[dest], &pv->items[run], \
+                        (i - run) * sizeof(T)); \
+            } \
+            dest += i - run; \
+            if (i < n) \
+            { \
+                ++i; \
+                while ((i < n) && (*pred)(i, &pv->items[i])) \
+                { \
+                    ++i; \
+                } \
+            } \
+            kept = (i < n); \
+        } \
+        pv->num_items = dest; \
+        assert(name##_valid(pv)); \
+        return n - dest; \
+    } \
+    \
+    VEC2_INLINE_FN vec2_bool \
+    name##_erase_indices(name *pv, const size_t *indexes, size_t count) \
+    { \
+        size_t i, j, n, dest; \
+        VEC2_STATUS_INIT(ret, false); \
+        assert(name##_valid(pv)); \
+        assert((indexes != NULL) || (count == 0U)); \
+        assert((count == 0U) || (indexes[count - 1] < pv->num_items)); \
+        if ((count == 0U) || (indexes[count - 1] < pv->num_items)) \
+        { \
+            n = pv->num_items; \
+            dest = i = (count > 0U) ? indexes[0] : n; \
+            for (j = 0; j < count; ++j) \
+            { \
+                if (indexes[j] >= i) \
+                { \
+                    memmove(&pv->items[dest], &pv->items[i], \
+                            (indexes[j] - i) * sizeof(T)); \
+                    dest += indexes[j] - i; \
+                    i = indexes[j] + 1; \
+                } \
+            } \
+            memmove(&pv->items[dest], &pv->items[i], (n - i) * sizeof(T)); \
+            pv->num_items = dest + (n - i); \
+            VEC2_STATUS_SET(ret, true); \
+        } \
+        assert(name##_valid(pv)); \
+        VEC2_STATUS_RETURN(ret); \
+    }
+
+/****************************************************************************/
+/* iteration and searching */
+
+#define VEC2_DECLARE_ITERATE_(name,T) \
+    VEC2_INLINE_FN void name##_foreach(name *pv, name##_FOREACH_FN fn) \
+    { \
+        size_t i, count; \
+        assert(name##_valid(pv)); \
+        assert(fn != NULL); \
+        count = pv->num_items; \
+        for (i = 0; i < count; ++i) \
+        { \
+            if ((*fn)(i, &pv->items[i]) == false) \
+            { \
+                break; \
+            } \
+        } \
+    } \
+    \
+    VEC2_INLINE_FN void \
+    name##_foreach_reverse(name *pv, name##_FOREACH_FN fn) \
+    { \
+        size_t i, count; \
+        assert(name##_valid(pv)); \
+        assert(fn != NULL); \
+        count = pv->num_items; \
+        for (i = count - 1; i < count; --i) \
+        { \
+            if ((*fn)(i, &pv->items[i]) == false) \
+            { \
+                break; \
+            } \
+        } \
+    } \
+    \
+    VEC2_INLINE_FN void \
+    name##_foreach_range(name *pv, name##_FOREACH_FN fn, \
+                         size_t index0, size_t count) \
+    { \
+        size_t i; \
+        assert(name##_valid(pv)); \
+        assert(fn != NULL); \
+        assert(index0 < pv->num_items); \
+        assert((index0 + count) <= pv->num_items); \
+        for (i = index0; i < index0 + count; ++i) \
+        { \
+            if ((*fn)(i, &pv->items[i]) == false) \
+            { \
+                break; \
+            } \
+        } \
+    } \
+    \
+    VEC2_INLINE_FN void \
+    name##_foreach_batch(name *pv, name##_BATCH_FN fn, size_t batch_hint) \
+    { \
+        size_t i, span, count; \
+        assert(name##_valid(pv)); \
+        assert(fn != NULL); \
+        if (batch_hint == 0U) \
+        { \
+            batch_hint = (sizeof(T) < VEC2_BATCH_BYTES) ? \
+                         VEC2_BATCH_BYTES / sizeof(T) : 1U; \
+        } \
+        count = pv->num_items; \
+        for (i = 0; i < count; i += span) \
+        { \
+            span = (count - i < batch_hint) ? count - i : batch_hint; \
+            if ((*fn)(i, &pv->items[i], span) == false) \
+            { \
+                break; \
+            } \
+        } \
+    } \
+    \
+    VEC2_INLINE_FN T * \
+    name##_find(name *pv, const T *pitem, VEC2_ITEM_COMPARE_FN compare) \
+    { \
+        size_t i, count; \
+        T *ret = NULL; \
+        assert(name##_valid(pv)); \
+        assert(pitem != NULL); \
+        assert(compare != NULL); \
+        count = pv->num_items; \
+        for (i = 0; i < count; ++i) \
+        { \
+            if ((*compare)(pitem, &pv->items[i]) == 0) \
+            { \
+                ret = &pv->items[i]; \
+                break; \
+            } \
+        } \
+        return ret; \
+    }
+
+#ifndef MISRA_C
+    /* NOTE: name##_bsearch() and name##_sort() aren't available in MISRA-C. */
+    #define VEC2_DECLARE_SORT_(name,T) \
+        VEC2_INLINE_FN T * \
+        name##_bsearch(name *pv, const T *pitem, VEC2_ITEM_COMPARE_FN compare) \
+        { \
+            assert(name##_valid(pv)); \
+            assert(pitem != NULL); \
+            assert(compare != NULL); \
+            return (T *)bsearch(pitem, pv->items, pv->num_items, \
+                                sizeof(T), compare); \
+        } \
+        \
+        VEC2_INLINE_FN void name##_sort(name *pv, VEC2_ITEM_COMPARE_FN compare) \
+        { \
+            assert(name##_valid(pv)); \
+            assert(compare != NULL); \
+            qsort(pv->items, pv->num_items, sizeof(T), compare); \
+        }
+#else
+    #define VEC2_DECLARE_SORT_(name,T)  /* empty */
+#endif  /* ndef MISRA_C */
+
+/****************************************************************************/
+/* the generator */
+
+#define VEC2_DECLARE(name,T) \
+    VEC2_DECLARE_TYPE_(name, T) \
+    VEC2_DECLARE_BASIC_(name, T) \
+    VEC2_DECLARE_MODIFY_(name, T) \
+    VEC2_DECLARE_ITERATE_(name, T) \
+    VEC2_DECLARE_SORT_(name, T)
+
+/****************************************************************************/
+
+#endif  /* ndef KATAHIROMZ_VEC2_TYPED_H */